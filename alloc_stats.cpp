@@ -0,0 +1,137 @@
+#include "alloc_stats.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <malloc.h>
+
+// Relaxed counters: snapshots are taken on the main thread, the counts of
+// other threads only have to add up
+static std::atomic<uint64_t> allocCnt(0);
+static std::atomic<uint64_t> allocBytes(0);
+static std::atomic<uint64_t> liveBytes(0);
+static std::atomic<uint64_t> peakBytes(0);
+
+#ifdef CHESS_ALLOC_STATS
+// Counts a block (its usable size, which is also what its delete subtracts)
+static void* countAlloc(void* ptr)
+{
+    if (ptr == nullptr)
+    {
+        return nullptr;
+    }
+    uint64_t size = malloc_usable_size(ptr);
+    allocCnt.fetch_add(1, std::memory_order_relaxed);
+    allocBytes.fetch_add(size, std::memory_order_relaxed);
+    uint64_t live = liveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+    uint64_t peak = peakBytes.load(std::memory_order_relaxed);
+    while (live > peak && !peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+    {
+    }
+    return ptr;
+}
+
+static void countFree(void* ptr)
+{
+    if (ptr != nullptr)
+    {
+        liveBytes.fetch_sub(malloc_usable_size(ptr), std::memory_order_relaxed);
+        std::free(ptr);
+    }
+}
+
+static void* allocBlock(std::size_t size)
+{
+    return countAlloc(std::malloc(size == 0 ? 1 : size));
+}
+
+static void* allocAligned(std::size_t size, std::align_val_t align)
+{
+    void* ptr = nullptr;
+    std::size_t alignment = static_cast<std::size_t>(align);
+    if (posix_memalign(&ptr, alignment < sizeof(void*) ? sizeof(void*) : alignment, size == 0 ? 1 : size) != 0)
+    {
+        return nullptr;
+    }
+    return countAlloc(ptr);
+}
+
+void* operator new(std::size_t size)
+{
+    void* ptr = allocBlock(size);
+    if (ptr == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return allocBlock(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t align)
+{
+    void* ptr = allocAligned(size, align);
+    if (ptr == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new(std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept
+{
+    return allocAligned(size, align);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    countFree(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    countFree(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+    countFree(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+    countFree(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept
+{
+    countFree(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    countFree(ptr);
+}
+#endif
+
+allocStatsT getAllocStats()
+{
+    return {allocCnt.load(std::memory_order_relaxed), allocBytes.load(std::memory_order_relaxed),
+            liveBytes.load(std::memory_order_relaxed), peakBytes.load(std::memory_order_relaxed)};
+}
+
+void resetAllocPeak()
+{
+    peakBytes.store(liveBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+void printAllocStats(std::ostream& out, const char* label, const allocStatsT& before, const allocStatsT& after)
+{
+    int64_t liveDiff = static_cast<int64_t>(after.liveBytes) - static_cast<int64_t>(before.liveBytes);
+    out << label << ": " << after.allocations - before.allocations << " allocations, "
+        << (after.bytes - before.bytes) / 1024.0 << " KB allocated, peak "
+        << (after.peakBytes > before.liveBytes ? after.peakBytes - before.liveBytes : 0) / 1024.0 << " KB, live "
+        << (liveDiff >= 0 ? "+" : "") << liveDiff / 1024.0 << " KB" << std::endl;
+}
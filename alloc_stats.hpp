@@ -0,0 +1,32 @@
+#ifndef ALLOC_STATS_HPP
+#define ALLOC_STATS_HPP
+
+#include <cstdint>
+#include <ostream>
+
+// Heap use through operator new. Built with CHESS_ALLOC_STATS defined,
+// alloc_stats.cpp replaces the global operator new and delete, so every C++
+// allocation of the program (shared libraries included) is counted. Without
+// it the standard allocator is kept and the counters stay at zero.
+#ifdef CHESS_ALLOC_STATS
+const bool ALLOC_STATS_ENABLED = true;
+#else
+const bool ALLOC_STATS_ENABLED = false;
+#endif
+
+typedef struct
+{
+    uint64_t allocations;
+    uint64_t bytes;            // Allocated so far, freed blocks included
+    uint64_t liveBytes;
+    uint64_t peakBytes;        // Most live bytes since the last resetAllocPeak
+} allocStatsT;
+
+allocStatsT getAllocStats();
+// Restarts the peak from the live bytes
+void resetAllocPeak();
+// Prints the heap use between two snapshots (the peak is the one of the second,
+// reported above the live bytes of the first)
+void printAllocStats(std::ostream& out, const char* label, const allocStatsT& before, const allocStatsT& after);
+
+#endif
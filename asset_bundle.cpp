@@ -0,0 +1,219 @@
+#include "asset_bundle.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+assetBundle::assetBundle()
+{
+    base = nullptr;
+    mapSize = 0;
+    entries = nullptr;
+    entryCount = 0;
+}
+
+assetBundle::~assetBundle()
+{
+    close();
+}
+
+bool assetBundle::open(const char* path)
+{
+    close();
+
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(assetBundleHeaderT)))
+    {
+        ::close(fd);
+        return false;
+    }
+    void* mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps the file alive
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        return false;
+    }
+    base = static_cast<const unsigned char*>(mapping);
+    mapSize = static_cast<std::size_t>(st.st_size);
+
+    // Validate the header and every entry once, so lookups can trust them
+    const assetBundleHeaderT* header = reinterpret_cast<const assetBundleHeaderT*>(base);
+    if (header->magic != ASSET_BUNDLE_MAGIC || header->version != ASSET_BUNDLE_VERSION ||
+        header->tocOffset > mapSize ||
+        (mapSize - header->tocOffset) / sizeof(assetEntryT) < header->entryCount)
+    {
+        close();
+        return false;
+    }
+    entries = reinterpret_cast<const assetEntryT*>(base + header->tocOffset);
+    entryCount = header->entryCount;
+    for (uint32_t i = 0; i < entryCount; i++)
+    {
+        const assetEntryT& entry = entries[i];
+        if (entry.name[ASSET_NAME_LEN - 1] != '\0' ||
+            entry.offset > mapSize || entry.size > mapSize - entry.offset)
+        {
+            close();
+            return false;
+        }
+    }
+
+    madvise(const_cast<unsigned char*>(base), mapSize, MADV_WILLNEED);
+    return true;
+}
+
+void assetBundle::close()
+{
+    if (base != nullptr)
+    {
+        munmap(const_cast<unsigned char*>(base), mapSize);
+    }
+    base = nullptr;
+    mapSize = 0;
+    entries = nullptr;
+    entryCount = 0;
+}
+
+bool assetBundle::isOpen() const
+{
+    return base != nullptr;
+}
+
+const assetEntryT* assetBundle::findEntry(uint32_t type, std::string_view name) const
+{
+    uint32_t lo = 0;
+    uint32_t hi = entryCount;
+
+    while (lo < hi)
+    {
+        uint32_t mid = (lo + hi) / 2;
+        int order = (type != entries[mid].type) ? ((type < entries[mid].type) ? -1 : 1) : name.compare(entries[mid].name);
+        if (order == 0)
+        {
+            return &entries[mid];
+        }
+        if (order < 0)
+        {
+            hi = mid;
+        }
+        else
+        {
+            lo = mid + 1;
+        }
+    }
+    return nullptr;
+}
+
+GLuint assetBundle::loadTexture(std::string_view name) const
+{
+    const assetEntryT* entry = findEntry(ASSET_TEXTURE, name);
+    if (entry == nullptr || entry->mipCount == 0)
+    {
+        return 0;
+    }
+    // Without S3TC the levels would upload as nothing (black), take the BMP
+    if (!GLEW_EXT_texture_compression_s3tc)
+    {
+        return 0;
+    }
+
+    GLuint textureID;
+    glGenTextures(1, &textureID);
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    // Errors from earlier calls must not be taken for an upload failure
+    while (glGetError() != GL_NO_ERROR)
+    {
+    }
+
+    // Upload every level straight from the mapping
+    uint32_t width = entry->width;
+    uint32_t height = entry->height;
+    uint64_t offset = entry->offset;
+    uint64_t end = entry->offset + entry->size;
+    uint32_t level = 0;
+    for (; level < entry->mipCount; level++)
+    {
+        uint64_t levelSize = bc1LevelSize(width, height);
+        if (offset + levelSize > end)
+        {
+            break;
+        }
+        glCompressedTexImage2D(GL_TEXTURE_2D, level, entry->format, width, height, 0,
+                               static_cast<GLsizei>(levelSize), base + offset);
+        if (level == 0 && glGetError() != GL_NO_ERROR)
+        { // Format rejected by the driver
+            glBindTexture(GL_TEXTURE_2D, 0);
+            glDeleteTextures(1, &textureID);
+            return 0;
+        }
+        offset += levelSize;
+        width = (width > 1) ? width / 2 : 1;
+        height = (height > 1) ? height / 2 : 1;
+    }
+
+    // Trilinear filtering over the cooked chain
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (level > 0) ? level - 1 : 0);
+
+    return textureID;
+}
+
+bool assetBundle::getModelMeshes(std::string_view objPath, std::vector<assetMeshT>& meshes) const
+{
+    meshes.clear();
+    const assetEntryT* model = findEntry(ASSET_MODEL, objPath);
+    if (model == nullptr || model->offset % sizeof(uint32_t) != 0 || model->size % sizeof(uint32_t) != 0)
+    {
+        return false;
+    }
+    const uint32_t* meshIdx = reinterpret_cast<const uint32_t*>(base + model->offset);
+    std::size_t meshCnt = model->size / sizeof(uint32_t);
+    meshes.reserve(meshCnt);
+    for (std::size_t i = 0; i < meshCnt; i++)
+    {
+        if (meshIdx[i] >= entryCount)
+        {
+            return false;
+        }
+        // The arrays are read in place, so they must be aligned and fill the payload exactly
+        const assetEntryT& entry = entries[meshIdx[i]];
+        if (entry.type != ASSET_MESH || entry.offset % sizeof(float) != 0 || entry.size < sizeof(assetMeshHeaderT))
+        {
+            return false;
+        }
+        const assetMeshHeaderT* header = reinterpret_cast<const assetMeshHeaderT*>(base + entry.offset);
+        if (header->name[ASSET_NAME_LEN - 1] != '\0' || header->texturePath[ASSET_PATH_LEN - 1] != '\0' ||
+            header->indexCount % 3 != 0 || entry.size != meshPayloadSize(header->vertexCount, header->indexCount, header->flags))
+        {
+            return false;
+        }
+        assetMeshT mesh;
+        mesh.header = header;
+        const float* arrays = reinterpret_cast<const float*>(header + 1);
+        mesh.positions = arrays;
+        arrays += 3 * static_cast<std::size_t>(header->vertexCount);
+        mesh.normals = (header->flags & ASSET_MESH_NORMALS) ? arrays : nullptr;
+        arrays += (mesh.normals != nullptr) ? 3 * static_cast<std::size_t>(header->vertexCount) : 0;
+        mesh.uvs = (header->flags & ASSET_MESH_UVS) ? arrays : nullptr;
+        arrays += (mesh.uvs != nullptr) ? 2 * static_cast<std::size_t>(header->vertexCount) : 0;
+        mesh.indices = reinterpret_cast<const uint16_t*>(arrays);
+        for (uint32_t k = 0; k < header->indexCount; k++)
+        {
+            if (mesh.indices[k] >= header->vertexCount)
+            {
+                return false;
+            }
+        }
+        meshes.push_back(mesh);
+    }
+    return true;
+}
@@ -0,0 +1,127 @@
+#ifndef ASSET_BUNDLE_HPP
+#define ASSET_BUNDLE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#ifndef ASSET_BUNDLE_NO_GL
+#include <GL/glew.h>
+#endif
+
+// Packed asset bundle written by asset_cook and streamed by the viewer.
+// Layout: header, payloads (8 byte aligned), TOC sorted by type then name.
+#define ASSET_BUNDLE_FILE "assets.bundle"
+#define ASSET_BUNDLE_MAGIC 0x42414843u   // "CHAB"
+#define ASSET_BUNDLE_VERSION 2u          // 2: meshes and models
+#define ASSET_NAME_LEN 64
+#define ASSET_PATH_LEN 128
+
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+
+// Entry kinds
+#define ASSET_TEXTURE 1u                 // Payload: BC1 mip chain, largest level first
+#define ASSET_MESH 2u                    // Payload: assetMeshHeaderT and the mesh arrays
+#define ASSET_MODEL 3u                   // Payload: TOC indices (uint32) of the meshes of an OBJ file
+
+// Mesh arrays present besides the positions and indices
+#define ASSET_MESH_NORMALS 1u
+#define ASSET_MESH_UVS 2u
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t reserved;
+    uint64_t tocOffset;
+} assetBundleHeaderT;
+
+typedef struct
+{
+    char name[ASSET_NAME_LEN];   // Texture: file stem as referenced by the MTL ("wooddark3")
+                                 // Model: OBJ path as the viewer loads it
+                                 // Mesh: OBJ file stem and mesh number ("chess-mod/003")
+    uint32_t type;               // ASSET_TEXTURE, ASSET_MESH or ASSET_MODEL
+    uint32_t format;             // GL compressed internal format (textures)
+    uint32_t width;              // Level 0 size (textures)
+    uint32_t height;
+    uint32_t mipCount;
+    uint32_t reserved;
+    uint64_t offset;             // Payload offset from the start of the bundle
+    uint64_t size;               // Payload size (all levels)
+} assetEntryT;
+
+// Mesh payload: this header, then positions, normals (3 floats per vertex),
+// texture coordinates (2 floats per vertex) and 16 bit triangle indices.
+// Normals and texture coordinates are only stored when the flags say so.
+typedef struct
+{
+    char name[ASSET_NAME_LEN];          // Component name (OBJ object or group)
+    char texturePath[ASSET_PATH_LEN];   // Diffuse BMP from the working directory, "" for none
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t flags;                     // ASSET_MESH_NORMALS, ASSET_MESH_UVS
+    uint32_t reserved;
+} assetMeshHeaderT;
+
+// Size of a mesh payload
+inline uint64_t meshPayloadSize(uint32_t vertexCount, uint32_t indexCount, uint32_t flags)
+{
+    uint64_t floatsPerVertex = 3 + ((flags & ASSET_MESH_NORMALS) ? 3 : 0) + ((flags & ASSET_MESH_UVS) ? 2 : 0);
+    return sizeof(assetMeshHeaderT) + floatsPerVertex * sizeof(float) * vertexCount + sizeof(uint16_t) * indexCount;
+}
+
+// Size of a BC1 compressed level
+inline uint64_t bc1LevelSize(uint32_t width, uint32_t height)
+{
+    return static_cast<uint64_t>((width + 3) / 4) * ((height + 3) / 4) * 8;
+}
+
+#ifndef ASSET_BUNDLE_NO_GL
+// Cooked mesh (pointers into the mapping, normals and uvs are nullptr when
+// the mesh has none)
+typedef struct
+{
+    const assetMeshHeaderT* header;
+    const float* positions;
+    const float* normals;
+    const float* uvs;
+    const uint16_t* indices;
+} assetMeshT;
+
+// Read-only view of a bundle (memory mapped, textures are uploaded straight
+// from the mapping with no decoding)
+class assetBundle
+{
+private:
+    const unsigned char* base;
+    std::size_t mapSize;
+    const assetEntryT* entries;
+    uint32_t entryCount;
+
+public:
+    assetBundle();
+    ~assetBundle();
+    assetBundle(const assetBundle&) = delete;
+    assetBundle& operator=(const assetBundle&) = delete;
+
+    // Maps a bundle and validates its table of contents
+    bool open(const char* path);
+    // Releases the mapping (textures already uploaded stay valid)
+    void close();
+    bool isOpen() const;
+    // Looks up an entry by type and name (binary search over the sorted TOC)
+    const assetEntryT* findEntry(uint32_t type, std::string_view name) const;
+    // Creates a GL texture from a cooked entry, 0 if it is not in the bundle
+    // or the GL cannot take S3TC (callers fall back to the source image)
+    GLuint loadTexture(std::string_view name) const;
+    // Meshes cooked from an OBJ file, in file order (checked: sizes and
+    // indices), false if the file was not cooked or its entries are damaged
+    bool getModelMeshes(std::string_view objPath, std::vector<assetMeshT>& meshes) const;
+};
+#endif
+
+#endif
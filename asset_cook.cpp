@@ -0,0 +1,787 @@
+/*
+Objective:
+Offline asset cooker (separate executable, not linked into the viewer)
+Description :
+    Reads the OBJ/MTL/BMP sources once, resolves the texture references of every
+    material, builds full mip chains, compresses them to BC1, splits the OBJ
+    files into meshes the way the viewer's AssImp import does (one per object
+    or group and material, triangulated, identical vertices joined) and writes
+    a single packed bundle (see asset_bundle.hpp) that the viewer streams at
+    startup.
+
+    Build   : g++ -O2 -std=c++17 asset_cook.cpp -o asset_cook
+    Usage   : asset_cook [output bundle] [OBJ or MTL files...]
+    Default : asset_cook assets.bundle Lab3/Stone_Chess_Board/12951_Stone_Chess_Board_v1_L3.obj Lab3/Chess/chess-mod.obj
+*/
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+// Bundle format only (the cooker has no GL dependency)
+#define ASSET_BUNDLE_NO_GL
+#include "asset_bundle.hpp"
+
+// Texture to cook
+typedef struct
+{
+    std::string name;          // Stem referenced by the material
+    std::string sourcePath;    // Resolved BMP path
+} cookTextureT;
+
+// Material of an MTL file (only its diffuse texture matters)
+typedef struct
+{
+    std::string name;
+    std::string texturePath;   // Resolved BMP path, empty for none
+} cookMaterialT;
+
+// Mesh to cook (one per object or group and material)
+typedef struct
+{
+    std::string name;          // Object or group name, the viewer's component name
+    std::string texturePath;
+    std::vector<float> positions;
+    std::vector<float> normals;
+    std::vector<float> uvs;
+    std::vector<uint16_t> indices;
+    bool hasNormals;
+    bool hasUvs;
+    bool tooLarge;             // More vertices than 16 bit indices address
+    // Vertex of every position/UV/normal combination (OBJ indices, -1 for none)
+    std::map<std::tuple<int, int, int>, uint16_t> vertexMap;
+} cookMeshT;
+
+// OBJ file to cook (its meshes in file order)
+typedef struct
+{
+    std::string objPath;       // As given, the viewer looks it up the same way
+    std::vector<std::size_t> meshes;
+} cookModelT;
+
+// Most vertices a mesh may have (16 bit indices)
+const std::size_t MAX_MESH_VERTICES = 65536;
+
+// Decoded image (RGB8, rows in file order which is GL's bottom-up order)
+typedef struct
+{
+    uint32_t width;
+    uint32_t height;
+    std::vector<unsigned char> rgb;
+} cookImageT;
+
+static bool fileExists(const std::string& path)
+{
+    std::ifstream file(path);
+    return file.good();
+}
+
+static std::string directoryOf(const std::string& path)
+{
+    std::size_t slash = path.find_last_of('/');
+    return (slash == std::string::npos) ? std::string() : path.substr(0, slash + 1);
+}
+
+static std::string stemOf(const std::string& path)
+{
+    std::size_t slash = path.find_last_of("/\\");
+    std::string name = (slash == std::string::npos) ? path : path.substr(slash + 1);
+    std::size_t dot = name.find_last_of('.');
+    return (dot == std::string::npos) ? name : name.substr(0, dot);
+}
+
+static std::string trim(const std::string& text)
+{
+    std::size_t first = text.find_first_not_of(" \t\r\n");
+    if (first == std::string::npos)
+    {
+        return std::string();
+    }
+    std::size_t last = text.find_last_not_of(" \t\r\n");
+    return text.substr(first, last - first + 1);
+}
+
+// Resolves a map_Kd reference: as written, then the BMP with the same stem
+// (the MTL files name .jpg textures that only exist as .bmp)
+static bool resolveTexture(const std::string& mtlDir, const std::string& reference, std::string& path)
+{
+    std::string candidates[2] =
+    {
+        mtlDir + reference,
+        mtlDir + stemOf(reference) + ".bmp"
+    };
+    for (const auto& candidate : candidates)
+    {
+        std::string ext = candidate.substr(candidate.find_last_of('.') + 1);
+        if ((ext == "bmp" || ext == "BMP") && fileExists(candidate))
+        {
+            path = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool parseMtl(const std::string& mtlPath, std::vector<cookTextureT>& textures,
+                     std::vector<cookMaterialT>& materials)
+{
+    std::ifstream file(mtlPath);
+    if (!file.is_open())
+    {
+        std::cout << "Cannot open material library " << mtlPath << std::endl;
+        return false;
+    }
+
+    std::string line;
+    bool ok = true;
+    while (std::getline(file, line))
+    {
+        line = trim(line);
+        if (line.compare(0, 7, "newmtl ") == 0)
+        {
+            materials.push_back({trim(line.substr(7)), std::string()});
+            continue;
+        }
+        if (line.compare(0, 7, "map_Kd ") != 0)
+        {
+            continue;
+        }
+        std::string reference = trim(line.substr(7));
+        cookTextureT texture;
+        texture.name = stemOf(reference);
+        if (texture.name.size() >= ASSET_NAME_LEN)
+        {
+            std::cout << "Texture name too long: " << texture.name << std::endl;
+            ok = false;
+            continue;
+        }
+        if (!resolveTexture(directoryOf(mtlPath), reference, texture.sourcePath))
+        {
+            std::cout << "Texture " << reference << " referenced by " << mtlPath << " not found" << std::endl;
+            ok = false;
+            continue;
+        }
+        if (texture.sourcePath.size() >= ASSET_PATH_LEN)
+        {
+            std::cout << "Texture path too long: " << texture.sourcePath << std::endl;
+            ok = false;
+            continue;
+        }
+        if (!materials.empty())
+        {
+            materials.back().texturePath = texture.sourcePath;
+        }
+        // Shared textures are cooked once
+        auto same = [&](const cookTextureT& t) { return t.name == texture.name; };
+        if (std::find_if(textures.begin(), textures.end(), same) == textures.end())
+        {
+            textures.push_back(texture);
+        }
+    }
+    return ok;
+}
+
+// Starts a mesh
+static void addMesh(std::vector<cookMeshT>& meshes, cookModelT& model, const std::string& name,
+                    const std::string& texturePath)
+{
+    model.meshes.push_back(meshes.size());
+    meshes.push_back({name, texturePath, {}, {}, {}, {}, false, false, false, {}});
+}
+
+// Parses an OBJ index ("7", "-1"), relative indices count back from the end
+// Inputs: index text, count of the elements read so far
+// Output: 0 based index, -1 if missing or out of range
+static int parseObjIndex(const std::string& text, std::size_t count)
+{
+    if (text.empty())
+    {
+        return -1;
+    }
+    long value = std::strtol(text.c_str(), nullptr, 10);
+    long index = (value < 0) ? static_cast<long>(count) + value : value - 1;
+    return (index >= 0 && index < static_cast<long>(count)) ? static_cast<int>(index) : -1;
+}
+
+// Vertex of a face corner ("v", "v/vt", "v//vn" or "v/vt/vn"), joined with
+// identical corners
+// Inputs: mesh, corner text, OBJ arrays
+// Output: vertex index, -1 for a bad corner
+static int addCorner(cookMeshT& mesh, const std::string& corner, const std::vector<float>& positions,
+                     const std::vector<float>& uvs, const std::vector<float>& normals)
+{
+    std::size_t slash1 = corner.find('/');
+    std::size_t slash2 = (slash1 == std::string::npos) ? std::string::npos : corner.find('/', slash1 + 1);
+    int vIdx = parseObjIndex(corner.substr(0, slash1), positions.size() / 3);
+    int tIdx = (slash1 == std::string::npos) ? -1 :
+               parseObjIndex(corner.substr(slash1 + 1, slash2 - slash1 - 1), uvs.size() / 2);
+    int nIdx = (slash2 == std::string::npos) ? -1 : parseObjIndex(corner.substr(slash2 + 1), normals.size() / 3);
+    if (vIdx < 0)
+    {
+        return -1;
+    }
+
+    auto found = mesh.vertexMap.find(std::make_tuple(vIdx, tIdx, nIdx));
+    if (found != mesh.vertexMap.end())
+    {
+        return found->second;
+    }
+    std::size_t vertexCnt = mesh.positions.size() / 3;
+    if (vertexCnt >= MAX_MESH_VERTICES)
+    {
+        mesh.tooLarge = true;
+        return -1;
+    }
+    mesh.vertexMap.emplace(std::make_tuple(vIdx, tIdx, nIdx), static_cast<uint16_t>(vertexCnt));
+    mesh.positions.insert(mesh.positions.end(), &positions[3 * vIdx], &positions[3 * vIdx + 3]);
+    // Missing normals stay zero (the viewer takes the face normals for them)
+    for (int c = 0; c < 3; c++)
+    {
+        mesh.normals.push_back((nIdx >= 0) ? normals[3 * nIdx + c] : 0.f);
+    }
+    for (int c = 0; c < 2; c++)
+    {
+        mesh.uvs.push_back((tIdx >= 0) ? uvs[2 * tIdx + c] : 0.f);
+    }
+    mesh.hasNormals = mesh.hasNormals || nIdx >= 0;
+    mesh.hasUvs = mesh.hasUvs || tIdx >= 0;
+    return static_cast<int>(vertexCnt);
+}
+
+static bool parseObj(const std::string& objPath, std::vector<cookTextureT>& textures,
+                     std::vector<cookMeshT>& meshes, std::vector<cookModelT>& models)
+{
+    std::ifstream file(objPath);
+    if (!file.is_open())
+    {
+        std::cout << "Cannot open " << objPath << std::endl;
+        return false;
+    }
+    if (objPath.size() >= ASSET_NAME_LEN || stemOf(objPath).size() + 5 >= ASSET_NAME_LEN)
+    {
+        std::cout << "OBJ path too long: " << objPath << std::endl;
+        return false;
+    }
+
+    models.push_back({objPath, {}});
+    cookModelT& model = models.back();
+    std::vector<cookMaterialT> materials;
+    std::vector<float> positions, uvs, normals;
+    // Like AssImp: a mesh per object or group, split again where the material
+    // changes, faces before any object go to "defaultobject"
+    std::string objectName = "defaultobject";
+    std::string materialName;
+    std::string texturePath;
+    std::size_t firstMesh = meshes.size();
+    std::string line;
+    bool ok = true;
+    while (std::getline(file, line))
+    {
+        line = trim(line);
+        std::istringstream fields(line);
+        std::string keyword;
+        fields >> keyword;
+        if (keyword == "v" || keyword == "vn")
+        {
+            float xyz[3] = {0.f, 0.f, 0.f};
+            fields >> xyz[0] >> xyz[1] >> xyz[2];
+            std::vector<float>& target = (keyword == "v") ? positions : normals;
+            target.insert(target.end(), xyz, xyz + 3);
+        }
+        else if (keyword == "vt")
+        {
+            float uv[2] = {0.f, 0.f};
+            fields >> uv[0] >> uv[1];
+            uvs.insert(uvs.end(), uv, uv + 2);
+        }
+        else if (keyword == "mtllib")
+        {
+            ok = parseMtl(directoryOf(objPath) + trim(line.substr(7)), textures, materials) && ok;
+        }
+        else if ((keyword == "o" || keyword == "g") && trim(line.substr(1)) != objectName)
+        {
+            objectName = trim(line.substr(1));
+            addMesh(meshes, model, objectName, texturePath);
+        }
+        else if (keyword == "usemtl")
+        {
+            std::string name = trim(line.substr(6));
+            auto same = [&](const cookMaterialT& m) { return m.name == name; };
+            auto material = std::find_if(materials.begin(), materials.end(), same);
+            texturePath = (material != materials.end()) ? material->texturePath : std::string();
+            if (name != materialName && meshes.size() > firstMesh && !meshes.back().indices.empty())
+            {
+                addMesh(meshes, model, objectName, texturePath);
+            }
+            else if (meshes.size() > firstMesh)
+            {
+                meshes.back().texturePath = texturePath;
+            }
+            materialName = name;
+        }
+        else if (keyword == "f")
+        {
+            if (meshes.size() == firstMesh)
+            {
+                addMesh(meshes, model, objectName, texturePath);
+            }
+            cookMeshT& mesh = meshes.back();
+            // Polygons become triangle fans
+            std::vector<int> corners;
+            std::string corner;
+            while (fields >> corner)
+            {
+                corners.push_back(addCorner(mesh, corner, positions, uvs, normals));
+            }
+            if (std::find(corners.begin(), corners.end(), -1) != corners.end())
+            {
+                if (!mesh.tooLarge)
+                {
+                    std::cout << "Bad face in " << objPath << ": " << line << std::endl;
+                    ok = false;
+                }
+                continue;
+            }
+            for (std::size_t c = 2; c < corners.size(); c++)
+            {
+                mesh.indices.insert(mesh.indices.end(), {static_cast<uint16_t>(corners[0]),
+                                                         static_cast<uint16_t>(corners[c - 1]),
+                                                         static_cast<uint16_t>(corners[c])});
+            }
+        }
+    }
+
+    // Meshes the viewer would skip are not cooked
+    std::vector<std::size_t> kept;
+    for (std::size_t mIdx : model.meshes)
+    {
+        cookMeshT& mesh = meshes[mIdx];
+        mesh.vertexMap.clear();
+        if (mesh.tooLarge)
+        {
+            std::cout << "Skipping mesh " << mesh.name << " of " << objPath << ": too many vertices" << std::endl;
+        }
+        else if (mesh.name.size() >= ASSET_NAME_LEN)
+        {
+            std::cout << "Mesh name too long: " << mesh.name << std::endl;
+            ok = false;
+        }
+        else if (!mesh.indices.empty())
+        {
+            kept.push_back(mIdx);
+        }
+    }
+    model.meshes = kept;
+    return ok;
+}
+
+// Loads an uncompressed 24/32 bit BMP
+static bool loadBmp(const std::string& path, cookImageT& image)
+{
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    unsigned char header[54];
+    if (!file.read(reinterpret_cast<char*>(header), sizeof(header)) ||
+        header[0] != 'B' || header[1] != 'M')
+    {
+        std::cout << path << " is not a BMP file" << std::endl;
+        return false;
+    }
+
+    uint32_t dataPos, compression;
+    int32_t width, height;
+    uint16_t bpp;
+    std::memcpy(&dataPos, &header[0x0A], 4);
+    std::memcpy(&width, &header[0x12], 4);
+    std::memcpy(&height, &header[0x16], 4);
+    std::memcpy(&bpp, &header[0x1C], 2);
+    std::memcpy(&compression, &header[0x1E], 4);
+    if ((bpp != 24 && bpp != 32) || compression != 0 || width <= 0 || height == 0)
+    {
+        std::cout << path << ": only uncompressed 24/32 bit BMPs are supported" << std::endl;
+        return false;
+    }
+
+    // Negative height means the rows are stored top-down
+    bool topDown = (height < 0);
+    uint32_t rows = static_cast<uint32_t>(topDown ? -height : height);
+    uint32_t bytesPerPixel = bpp / 8;
+    uint32_t stride = (static_cast<uint32_t>(width) * bytesPerPixel + 3) & ~3u;
+    std::vector<unsigned char> data(static_cast<std::size_t>(stride) * rows);
+    file.seekg(dataPos ? dataPos : 54);
+    if (!file.read(reinterpret_cast<char*>(data.data()), data.size()))
+    {
+        std::cout << path << ": truncated pixel data" << std::endl;
+        return false;
+    }
+
+    image.width = static_cast<uint32_t>(width);
+    image.height = rows;
+    image.rgb.resize(static_cast<std::size_t>(image.width) * rows * 3);
+    for (uint32_t y = 0; y < rows; y++)
+    {
+        const unsigned char* src = &data[static_cast<std::size_t>(topDown ? rows - 1 - y : y) * stride];
+        unsigned char* dst = &image.rgb[static_cast<std::size_t>(y) * image.width * 3];
+        for (uint32_t x = 0; x < image.width; x++)
+        {
+            // BGR(A) -> RGB
+            dst[3 * x + 0] = src[bytesPerPixel * x + 2];
+            dst[3 * x + 1] = src[bytesPerPixel * x + 1];
+            dst[3 * x + 2] = src[bytesPerPixel * x + 0];
+        }
+    }
+    return true;
+}
+
+// 2x2 box filter (odd edges are clamped)
+static cookImageT downsample(const cookImageT& src)
+{
+    cookImageT dst;
+    dst.width = (src.width > 1) ? src.width / 2 : 1;
+    dst.height = (src.height > 1) ? src.height / 2 : 1;
+    dst.rgb.resize(static_cast<std::size_t>(dst.width) * dst.height * 3);
+
+    for (uint32_t y = 0; y < dst.height; y++)
+    {
+        uint32_t y0 = std::min(2 * y, src.height - 1);
+        uint32_t y1 = std::min(2 * y + 1, src.height - 1);
+        for (uint32_t x = 0; x < dst.width; x++)
+        {
+            uint32_t x0 = std::min(2 * x, src.width - 1);
+            uint32_t x1 = std::min(2 * x + 1, src.width - 1);
+            for (uint32_t c = 0; c < 3; c++)
+            {
+                uint32_t sum = src.rgb[(static_cast<std::size_t>(y0) * src.width + x0) * 3 + c] +
+                               src.rgb[(static_cast<std::size_t>(y0) * src.width + x1) * 3 + c] +
+                               src.rgb[(static_cast<std::size_t>(y1) * src.width + x0) * 3 + c] +
+                               src.rgb[(static_cast<std::size_t>(y1) * src.width + x1) * 3 + c];
+                dst.rgb[(static_cast<std::size_t>(y) * dst.width + x) * 3 + c] = static_cast<unsigned char>((sum + 2) / 4);
+            }
+        }
+    }
+    return dst;
+}
+
+static uint16_t pack565(const int* rgb)
+{
+    return static_cast<uint16_t>(((rgb[0] * 31 + 127) / 255) << 11 |
+                                 ((rgb[1] * 63 + 127) / 255) << 5 |
+                                 ((rgb[2] * 31 + 127) / 255));
+}
+
+static void unpack565(uint16_t c, int* rgb)
+{
+    rgb[0] = ((c >> 11) & 31) * 255 / 31;
+    rgb[1] = ((c >> 5) & 63) * 255 / 63;
+    rgb[2] = (c & 31) * 255 / 31;
+}
+
+// Encodes one 4x4 block (bounding box endpoints inset by 1/16, nearest palette index)
+static void encodeBc1Block(const unsigned char block[16][3], unsigned char* out)
+{
+    int lo[3] = {255, 255, 255};
+    int hi[3] = {0, 0, 0};
+    for (int i = 0; i < 16; i++)
+    {
+        for (int c = 0; c < 3; c++)
+        {
+            lo[c] = std::min(lo[c], static_cast<int>(block[i][c]));
+            hi[c] = std::max(hi[c], static_cast<int>(block[i][c]));
+        }
+    }
+    for (int c = 0; c < 3; c++)
+    {
+        int inset = (hi[c] - lo[c]) / 16;
+        lo[c] += inset;
+        hi[c] -= inset;
+    }
+
+    uint16_t c0 = pack565(hi);
+    uint16_t c1 = pack565(lo);
+    // Four colour mode needs c0 > c1
+    if (c0 < c1)
+    {
+        std::swap(c0, c1);
+    }
+
+    int palette[4][3];
+    unpack565(c0, palette[0]);
+    unpack565(c1, palette[1]);
+    for (int c = 0; c < 3; c++)
+    {
+        palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+        palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+
+    uint32_t indices = 0;
+    if (c0 != c1)
+    {
+        for (int i = 0; i < 16; i++)
+        {
+            int best = 0;
+            int bestDist = 1 << 30;
+            for (int p = 0; p < 4; p++)
+            {
+                int dr = block[i][0] - palette[p][0];
+                int dg = block[i][1] - palette[p][1];
+                int db = block[i][2] - palette[p][2];
+                int dist = dr * dr + dg * dg + db * db;
+                if (dist < bestDist)
+                {
+                    bestDist = dist;
+                    best = p;
+                }
+            }
+            indices |= static_cast<uint32_t>(best) << (2 * i);
+        }
+    }
+
+    out[0] = static_cast<unsigned char>(c0 & 0xff);
+    out[1] = static_cast<unsigned char>(c0 >> 8);
+    out[2] = static_cast<unsigned char>(c1 & 0xff);
+    out[3] = static_cast<unsigned char>(c1 >> 8);
+    out[4] = static_cast<unsigned char>(indices & 0xff);
+    out[5] = static_cast<unsigned char>((indices >> 8) & 0xff);
+    out[6] = static_cast<unsigned char>((indices >> 16) & 0xff);
+    out[7] = static_cast<unsigned char>(indices >> 24);
+}
+
+static void encodeBc1(const cookImageT& image, std::vector<unsigned char>& out)
+{
+    std::size_t start = out.size();
+    out.resize(start + bc1LevelSize(image.width, image.height));
+    unsigned char* dst = &out[start];
+
+    for (uint32_t by = 0; by < image.height; by += 4)
+    {
+        for (uint32_t bx = 0; bx < image.width; bx += 4)
+        {
+            // Gather the block (edges replicate the last row/column)
+            unsigned char block[16][3];
+            for (uint32_t y = 0; y < 4; y++)
+            {
+                uint32_t sy = std::min(by + y, image.height - 1);
+                for (uint32_t x = 0; x < 4; x++)
+                {
+                    uint32_t sx = std::min(bx + x, image.width - 1);
+                    std::memcpy(block[4 * y + x], &image.rgb[(static_cast<std::size_t>(sy) * image.width + sx) * 3], 3);
+                }
+            }
+            encodeBc1Block(block, dst);
+            dst += 8;
+        }
+    }
+}
+
+// Full BC1 chain of a texture, down to 1x1
+static bool cookTexture(const cookTextureT& texture, assetEntryT& entry, std::vector<unsigned char>& payload)
+{
+    cookImageT image;
+    if (!loadBmp(texture.sourcePath, image))
+    {
+        return false;
+    }
+    entry.format = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    entry.width = image.width;
+    entry.height = image.height;
+    while (true)
+    {
+        encodeBc1(image, payload);
+        entry.mipCount++;
+        if (image.width == 1 && image.height == 1)
+        {
+            break;
+        }
+        image = downsample(image);
+    }
+    std::cout << texture.name << ": " << texture.sourcePath << " " << entry.width << "x" << entry.height
+              << ", " << entry.mipCount << " levels, " << payload.size() << " bytes" << std::endl;
+    return true;
+}
+
+template <typename T>
+static void appendArray(std::vector<unsigned char>& payload, const std::vector<T>& values)
+{
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(values.data());
+    payload.insert(payload.end(), bytes, bytes + values.size() * sizeof(T));
+}
+
+// Mesh header and arrays (see assetMeshHeaderT)
+static void cookMesh(const cookMeshT& mesh, std::vector<unsigned char>& payload)
+{
+    assetMeshHeaderT header = {};
+    std::strncpy(header.name, mesh.name.c_str(), ASSET_NAME_LEN - 1);
+    std::strncpy(header.texturePath, mesh.texturePath.c_str(), ASSET_PATH_LEN - 1);
+    header.vertexCount = static_cast<uint32_t>(mesh.positions.size() / 3);
+    header.indexCount = static_cast<uint32_t>(mesh.indices.size());
+    header.flags = (mesh.hasNormals ? ASSET_MESH_NORMALS : 0) | (mesh.hasUvs ? ASSET_MESH_UVS : 0);
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&header);
+    payload.insert(payload.end(), bytes, bytes + sizeof(header));
+    appendArray(payload, mesh.positions);
+    if (mesh.hasNormals)
+    {
+        appendArray(payload, mesh.normals);
+    }
+    if (mesh.hasUvs)
+    {
+        appendArray(payload, mesh.uvs);
+    }
+    appendArray(payload, mesh.indices);
+    std::cout << mesh.name << ": " << header.vertexCount << " vertices, " << header.indexCount / 3 << " triangles, "
+              << (mesh.texturePath.empty() ? "no texture" : mesh.texturePath.c_str()) << ", " << payload.size()
+              << " bytes" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    std::string outPath = ASSET_BUNDLE_FILE;
+    std::vector<std::string> inputs;
+    if (argc > 1)
+    {
+        outPath = argv[1];
+    }
+    for (int i = 2; i < argc; i++)
+    {
+        inputs.push_back(argv[i]);
+    }
+    if (inputs.empty())
+    { // Same sources as the viewer
+        inputs.push_back("Lab3/Stone_Chess_Board/12951_Stone_Chess_Board_v1_L3.obj");
+        inputs.push_back("Lab3/Chess/chess-mod.obj");
+    }
+
+    // Gather the meshes and resolve the texture references
+    std::vector<cookTextureT> textures;
+    std::vector<cookMeshT> meshes;
+    std::vector<cookModelT> models;
+    bool ok = true;
+    for (const auto& input : inputs)
+    {
+        bool isMtl = input.size() > 4 && input.compare(input.size() - 4, 4, ".mtl") == 0;
+        std::vector<cookMaterialT> materials;
+        ok = (isMtl ? parseMtl(input, textures, materials) : parseObj(input, textures, meshes, models)) && ok;
+    }
+    if (!ok)
+    {
+        std::cout << "Asset cooking failed, please CHECK!" << std::endl;
+        return -1;
+    }
+
+    // The viewer binary searches the TOC by type then name, and the model
+    // entries list their meshes by TOC index, so the order is settled first
+    // (second: index in textures, meshes or models)
+    std::vector<std::pair<assetEntryT, std::size_t>> toc;
+    auto addEntry = [&toc](uint32_t type, const std::string& name, std::size_t source)
+    {
+        assetEntryT entry = {};
+        std::strncpy(entry.name, name.c_str(), ASSET_NAME_LEN - 1);
+        entry.type = type;
+        toc.push_back({entry, source});
+    };
+    std::vector<std::string> meshNames(meshes.size());
+    for (std::size_t i = 0; i < textures.size(); i++)
+    {
+        addEntry(ASSET_TEXTURE, textures[i].name, i);
+    }
+    for (std::size_t i = 0; i < models.size(); i++)
+    {
+        addEntry(ASSET_MODEL, models[i].objPath, i);
+        for (std::size_t m = 0; m < models[i].meshes.size(); m++)
+        {
+            char number[24];
+            std::snprintf(number, sizeof(number), "/%03zu", m);
+            meshNames[models[i].meshes[m]] = stemOf(models[i].objPath) + number;
+            addEntry(ASSET_MESH, meshNames[models[i].meshes[m]], models[i].meshes[m]);
+        }
+    }
+    std::sort(toc.begin(), toc.end(), [](const std::pair<assetEntryT, std::size_t>& a,
+                                         const std::pair<assetEntryT, std::size_t>& b)
+    {
+        int order = std::strcmp(a.first.name, b.first.name);
+        return (a.first.type != b.first.type) ? a.first.type < b.first.type : order < 0;
+    });
+    std::vector<uint32_t> meshEntry(meshes.size());
+    for (std::size_t i = 0; i < toc.size(); i++)
+    {
+        if (i > 0 && toc[i].first.type == toc[i - 1].first.type && std::strcmp(toc[i].first.name, toc[i - 1].first.name) == 0)
+        {
+            std::cout << "Asset " << toc[i].first.name << " is cooked twice" << std::endl;
+            return -1;
+        }
+        if (toc[i].first.type == ASSET_MESH)
+        {
+            meshEntry[toc[i].second] = static_cast<uint32_t>(i);
+        }
+    }
+
+    std::ofstream out(outPath + ".tmp", std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!out.is_open())
+    {
+        std::cout << "Cannot write " << outPath << std::endl;
+        return -1;
+    }
+    assetBundleHeaderT header = {ASSET_BUNDLE_MAGIC, ASSET_BUNDLE_VERSION,
+                                 static_cast<uint32_t>(toc.size()), 0, 0};
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    // Payloads in TOC order, each 8 byte aligned so the viewer reads the
+    // mesh arrays in place
+    std::vector<unsigned char> payload;
+    uint64_t offset = sizeof(header);
+    for (auto& item : toc)
+    {
+        assetEntryT& entry = item.first;
+        payload.clear();
+        if (entry.type == ASSET_TEXTURE)
+        {
+            if (!cookTexture(textures[item.second], entry, payload))
+            {
+                return -1;
+            }
+        }
+        else if (entry.type == ASSET_MESH)
+        {
+            cookMesh(meshes[item.second], payload);
+        }
+        else
+        {
+            std::vector<uint32_t> meshIdx;
+            for (std::size_t mIdx : models[item.second].meshes)
+            {
+                meshIdx.push_back(meshEntry[mIdx]);
+            }
+            appendArray(payload, meshIdx);
+        }
+        entry.offset = offset;
+        entry.size = payload.size();
+        payload.resize((payload.size() + 7) & ~static_cast<std::size_t>(7), 0);
+        out.write(reinterpret_cast<const char*>(payload.data()), payload.size());
+        offset += payload.size();
+    }
+
+    // TOC at the end, then patch the header
+    header.tocOffset = offset;
+    for (const auto& item : toc)
+    {
+        out.write(reinterpret_cast<const char*>(&item.first), sizeof(assetEntryT));
+    }
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.close();
+    if (!out || std::rename((outPath + ".tmp").c_str(), outPath.c_str()) != 0)
+    {
+        std::cout << "Cannot write " << outPath << std::endl;
+        return -1;
+    }
+    std::cout << "Wrote " << textures.size() << " textures and " << toc.size() - textures.size() - models.size()
+              << " meshes of " << models.size() << " models to " << outPath << std::endl;
+    return 0;
+}
@@ -0,0 +1,124 @@
+#include "background_cache.hpp"
+#include <iostream>
+
+backgroundCache::backgroundCache()
+{
+    for (int t = 0; t < 2; t++)
+    {
+        fbos[t] = 0;
+        colorBufs[t] = 0;
+        depthBufs[t] = 0;
+    }
+    width = 0;
+    height = 0;
+    valid = false;
+}
+
+backgroundCache::~backgroundCache()
+{
+    release();
+}
+
+void backgroundCache::release()
+{
+    if (fbos[0] != 0)
+    {
+        glDeleteFramebuffers(2, fbos);
+        glDeleteRenderbuffers(2, colorBufs);
+        glDeleteRenderbuffers(2, depthBufs);
+    }
+    for (int t = 0; t < 2; t++)
+    {
+        fbos[t] = 0;
+        colorBufs[t] = 0;
+        depthBufs[t] = 0;
+    }
+    width = 0;
+    height = 0;
+    valid = false;
+}
+
+bool backgroundCache::resize(int width, int height)
+{
+    if (fbos[0] != 0 && width == this->width && height == this->height)
+    {
+        return true;
+    }
+    release();
+    if (width <= 0 || height <= 0)
+    {
+        return false;
+    }
+
+    // Same format and sample count for both, so copies between them are plain blits
+    GLint maxSamples = 0;
+    glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+    GLsizei samples = (BACKGROUND_CACHE_SAMPLES < maxSamples) ? BACKGROUND_CACHE_SAMPLES : maxSamples;
+    glGenFramebuffers(2, fbos);
+    glGenRenderbuffers(2, colorBufs);
+    glGenRenderbuffers(2, depthBufs);
+    bool complete = true;
+    for (int t = 0; t < 2; t++)
+    {
+        glBindRenderbuffer(GL_RENDERBUFFER, colorBufs[t]);
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA8, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, depthBufs[t]);
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_DEPTH_COMPONENT24, width, height);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbos[t]);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBufs[t]);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBufs[t]);
+        complete = complete && (glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+    }
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (!complete)
+    {
+        std::cout << "Background cache targets are not supported" << std::endl;
+        release();
+        return false;
+    }
+    this->width = width;
+    this->height = height;
+    return true;
+}
+
+bool backgroundCache::isValid() const
+{
+    return valid;
+}
+
+void backgroundCache::invalidate()
+{
+    valid = false;
+}
+
+void backgroundCache::beginBackground()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, fbos[0]);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    valid = true;
+}
+
+void backgroundCache::beginFrame(bool fromBackground)
+{
+    if (!fromBackground)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, fbos[1]);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        return;
+    }
+    // Depth comes along so the moving pieces are hidden behind static ones
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbos[0]);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbos[1]);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, width, height,
+                      GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbos[1]);
+}
+
+void backgroundCache::present()
+{
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbos[1]);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
@@ -0,0 +1,43 @@
+#ifndef BACKGROUND_CACHE_HPP
+#define BACKGROUND_CACHE_HPP
+
+#include <GL/glew.h>
+
+// Samples of the offscreen targets (the window itself is single sampled)
+const int BACKGROUND_CACHE_SAMPLES = 4;
+
+// Offscreen targets for redrawing only what moves. The static part of the
+// scene is drawn once into the background target; a frame starts from a copy
+// of its colour and depth, adds the moving part and is resolved to the window.
+class backgroundCache
+{
+private:
+    GLuint fbos[2];            // Background, frame
+    GLuint colorBufs[2];
+    GLuint depthBufs[2];
+    int width;
+    int height;
+    bool valid;
+
+public:
+    backgroundCache();
+    ~backgroundCache();
+    backgroundCache(const backgroundCache&) = delete;
+    backgroundCache& operator=(const backgroundCache&) = delete;
+
+    // Allocates the targets for a framebuffer size (kept while it is the same)
+    bool resize(int width, int height);
+    // The background holds the current static part
+    bool isValid() const;
+    void invalidate();
+    // Binds the background target, cleared (valid once drawn)
+    void beginBackground();
+    // Binds the frame target, starting from the background or cleared
+    void beginFrame(bool fromBackground);
+    // Resolves the frame into the window framebuffer (left bound)
+    void present();
+    // Frees the targets (call while the GL context is alive)
+    void release();
+};
+
+#endif
@@ -0,0 +1,159 @@
+/*
+Objective:
+Fixed timestep simulation clock and move animation definition file
+*/
+
+#include "chessAnimation.h"
+
+// Advance all the tracks by one tick
+// Inputs: None
+// Output: None
+void chessAnimator::tick()
+{
+    activeCnt = 0;
+    for (auto& track : tracks)
+    {
+        // Keep the previous tick for interpolation
+        track.prevPos = track.currPos;
+
+        if (track.tick >= track.duration)
+        { // Idle track
+            continue;
+        }
+        activeCnt++;
+        if (track.delay > 0)
+        { // Waiting for its turn
+            track.delay--;
+            continue;
+        }
+        if (track.tick == 0)
+        { // Start from wherever an earlier transition left the track
+            track.fromPos = track.currPos;
+        }
+
+        track.tick++;
+        float t = static_cast<float>(track.tick) / static_cast<float>(track.duration);
+        // Ease in/out
+        float s = t * t * (3.f - 2.f * t);
+        track.currPos = glm::mix(track.fromPos, track.toPos, s);
+        // Parabolic lift peaking at mid transition
+        track.currPos.z += track.arcHeight * 4.f * t * (1.f - t);
+    }
+}
+
+// Constructor function
+chessAnimator::chessAnimator()
+{
+    tracks.clear();
+    accumulator = 0.0;
+    activeCnt = 0;
+}
+
+// Allocate the tracks (the only allocation, done once)
+// Inputs: number of tracks
+// Output: None
+void chessAnimator::reserveTracks(unsigned int trackCnt)
+{
+    animTrackT idle = {};
+    tracks.assign(trackCnt, idle);
+    activeCnt = 0;
+}
+
+// Snap a track to a value with no transition
+// Inputs: track index, value
+// Output: None
+void chessAnimator::resetTrack(unsigned int tIdx, const glm::vec3& pos)
+{
+    animTrackT& track = tracks[tIdx];
+    track.fromPos = pos;
+    track.toPos = pos;
+    track.prevPos = pos;
+    track.currPos = pos;
+    track.arcHeight = 0.f;
+    track.delay = 0;
+    track.tick = 0;
+    track.duration = 0;
+}
+
+// Start a transition from the current value
+// Inputs: track index, target value, duration and delay in ticks, arc height
+// Output: None
+void chessAnimator::startTrack(unsigned int tIdx, const glm::vec3& toPos, unsigned int duration,
+                               unsigned int delay, float arcHeight)
+{
+    animTrackT& track = tracks[tIdx];
+    // The start value is taken when the delay runs out
+    track.fromPos = track.currPos;
+    track.toPos = toPos;
+    track.arcHeight = arcHeight;
+    track.delay = delay;
+    track.tick = 0;
+    // Zero length transitions still take a tick to land
+    track.duration = (duration > 0) ? duration : 1;
+    activeCnt++;
+}
+
+// Consume the elapsed frame time in fixed ticks
+// Inputs: elapsed time since the last call (seconds)
+// Output: number of ticks run
+unsigned int chessAnimator::advance(double frameTime)
+{
+    unsigned int tickCnt = 0;
+
+    // Clamp long stalls (window drag, debugger) instead of fast forwarding
+    if (frameTime > SIM_MAX_FRAME)
+    {
+        frameTime = SIM_MAX_FRAME;
+    }
+    accumulator += frameTime;
+
+    while (accumulator >= SIM_TICK)
+    {
+        tick();
+        accumulator -= SIM_TICK;
+        tickCnt++;
+    }
+    return tickCnt;
+}
+
+// Fraction of a tick left in the accumulator (for interpolation)
+// Inputs: None
+// Output: blend factor in [0, 1)
+float chessAnimator::getAlpha() const
+{
+    return static_cast<float>(accumulator / SIM_TICK);
+}
+
+// Interpolated value between the last two ticks
+// Inputs: track index, blend factor
+// Output: value
+glm::vec3 chessAnimator::getValue(unsigned int tIdx, float alpha) const
+{
+    const animTrackT& track = tracks[tIdx];
+    return glm::mix(track.prevPos, track.currPos, alpha);
+}
+
+// Get the target value of a track
+// Inputs: track index
+// Output: value
+glm::vec3 chessAnimator::getTarget(unsigned int tIdx) const
+{
+    return tracks[tIdx].toPos;
+}
+
+// Check for running transitions
+// Inputs: None
+// Output: true while any track is moving
+bool chessAnimator::isAnimating() const
+{
+    return activeCnt > 0;
+}
+
+// Check a single track
+// Inputs: track index
+// Output: true while the track is in (or just finished) a transition
+bool chessAnimator::isTrackMoving(unsigned int tIdx) const
+{
+    const animTrackT& track = tracks[tIdx];
+    return track.tick < track.duration || track.prevPos != track.currPos;
+}
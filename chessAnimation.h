@@ -0,0 +1,95 @@
+/*
+Objective:
+Fixed timestep simulation clock and move animation header file
+*/
+
+#ifndef CHESS_ANIMATION_H
+#define CHESS_ANIMATION_H
+
+#include <vector>
+
+// Include GLM
+#include <glm/glm.hpp>
+
+// Simulation tick length (seconds)
+const double SIM_TICK = 1.0 / 60.0;
+// Longest frame time the simulation catches up on (avoids a spiral of death)
+const double SIM_MAX_FRAME = 0.25;
+// Animation durations (ticks)
+const unsigned int MOVE_TICKS = 36;
+const unsigned int CAPTURE_TICKS = 24;
+const unsigned int CAMERA_TICKS = 45;
+// Height of the arc a moving piece follows
+const float MOVE_ARC = 1.5f;
+
+// Animation state of a single track
+typedef struct
+{
+    glm::vec3 fromPos;         // Start of the transition
+    glm::vec3 toPos;           // End of the transition
+    glm::vec3 prevPos;         // Value at the previous tick
+    glm::vec3 currPos;         // Value at the current tick
+    float arcHeight;           // Lift along Z at mid transition
+    unsigned int delay;        // Ticks to wait before starting
+    unsigned int tick;         // Ticks elapsed
+    unsigned int duration;     // Ticks for the whole transition
+} animTrackT;
+
+class chessAnimator
+{
+private:
+    // All the tracks, updated in one pass per tick
+    std::vector<animTrackT> tracks;
+    // Time not yet consumed by a tick (seconds)
+    double accumulator;
+    // Number of running transitions
+    unsigned int activeCnt;
+
+    // Advance all the tracks by one tick
+    // Inputs: None
+    // Output: None
+    void tick();
+
+public:
+    // Constructor function
+    chessAnimator();
+    // Allocate the tracks (the only allocation, done once)
+    // Inputs: number of tracks
+    // Output: None
+    void reserveTracks(unsigned int trackCnt);
+    // Snap a track to a value with no transition
+    // Inputs: track index, value
+    // Output: None
+    void resetTrack(unsigned int tIdx, const glm::vec3& pos);
+    // Start a transition from the current value
+    // Inputs: track index, target value, duration and delay in ticks, arc height
+    // Output: None
+    void startTrack(unsigned int tIdx, const glm::vec3& toPos, unsigned int duration,
+                    unsigned int delay = 0, float arcHeight = 0.f);
+    // Consume the elapsed frame time in fixed ticks
+    // Inputs: elapsed time since the last call (seconds)
+    // Output: number of ticks run
+    unsigned int advance(double frameTime);
+    // Fraction of a tick left in the accumulator (for interpolation)
+    // Inputs: None
+    // Output: blend factor in [0, 1)
+    float getAlpha() const;
+    // Interpolated value between the last two ticks
+    // Inputs: track index, blend factor
+    // Output: value
+    glm::vec3 getValue(unsigned int tIdx, float alpha) const;
+    // Get the target value of a track
+    // Inputs: track index
+    // Output: value
+    glm::vec3 getTarget(unsigned int tIdx) const;
+    // Check for running transitions
+    // Inputs: None
+    // Output: true while any track is moving
+    bool isAnimating() const;
+    // Check a single track
+    // Inputs: track index
+    // Output: true while the track is in (or just finished) a transition
+    bool isTrackMoving(unsigned int tIdx) const;
+};
+
+#endif
@@ -0,0 +1,447 @@
+/*
+Objective:
+Chess board state definition file
+*/
+
+#include <cmath>
+#include <cstdlib>
+#include "chessBoard.h"
+
+// Promotion component names per player (queen, rook, bishop, knight)
+static const char* PROMO_NAMES[2][4] =
+{
+    {"REGINA01", "TORRE02", "ALFIERE02", "Object02"},   // Second player
+    {"REGINA2",  "TORRE3",  "ALFIERE3",  "Object3"}     // First player
+};
+// Promotion piece letters matching the name order
+static const char PROMO_LETTERS[4] = {'q', 'r', 'b', 'n'};
+
+// Parse a square name ("e2")
+// Inputs: square characters
+// Output: true if the square is valid
+bool chessBoard::parseSquare(const char* sq, int& file, int& rank) const
+{
+    file = sq[0] - 'a';
+    rank = sq[1] - '1';
+    return (file >= 0 && file < 8 && rank >= 0 && rank < 8);
+}
+
+// Line up a captured piece next to the owner's side of the board
+// Inputs: piece, capture slot
+// Output: None
+static void lineUpPiece(pieceInstanceT& piece, unsigned int slot)
+{
+    float side = piece.isWhite ? 1.f : -1.f;
+    piece.file = -1;
+    piece.rank = -1;
+    piece.captured = true;
+    piece.captureSlot = slot;
+    piece.cTPosition.tPos.x = side * 5.f * CHESS_BOX_SIZE;
+    piece.cTPosition.tPos.y = side * (-3.5f + 0.5f * slot) * CHESS_BOX_SIZE;
+}
+
+// Move a piece off the board
+// Inputs: instance index
+// Output: None
+void chessBoard::capturePiece(int pIdx)
+{
+    pieceInstanceT& piece = pieces[pIdx];
+    unsigned int player = piece.isWhite ? 1 : 0;
+    squares[piece.file][piece.rank] = -1;
+    lineUpPiece(piece, capturedCnt[player]);
+    capturedCnt[player]++;
+}
+
+// Move a piece to a square
+// Inputs: instance index and target square
+// Output: None
+void chessBoard::placePiece(int pIdx, int file, int rank)
+{
+    pieceInstanceT& piece = pieces[pIdx];
+    squares[piece.file][piece.rank] = -1;
+    squares[file][rank] = pIdx;
+    piece.file = file;
+    piece.rank = rank;
+    piece.cTPosition.tPos = squarePosition(file, rank);
+}
+
+// Swap a pawn for a promotion piece (keeps its position)
+// Inputs: instance index, promotion kind
+// Output: true if the promotion piece exists
+bool chessBoard::promotePiece(int pIdx, int kind)
+{
+    pieceInstanceT& piece = pieces[pIdx];
+    int player = piece.isWhite ? 1 : 0;
+    if (promoCompIdx[player][kind] < 0)
+    {
+        return false;
+    }
+    piece.compIdx = promoCompIdx[player][kind];
+    glm::vec3 tPos = piece.cTPosition.tPos;
+    piece.cTPosition = promoTPosition[player][kind];
+    piece.cTPosition.tPos = tPos;
+    piece.isPawn = false;
+    piece.promoKind = kind;
+    return true;
+}
+
+// Constructor function
+chessBoard::chessBoard()
+{
+    // Empty board
+    for (int f = 0; f < 8; f++)
+    {
+        for (int r = 0; r < 8; r++)
+        {
+            squares[f][r] = -1;
+        }
+    }
+    capturedCnt[0] = 0;
+    capturedCnt[1] = 0;
+    whiteToMove = true;
+    epFile = -1;
+    for (int p = 0; p < 2; p++)
+    {
+        for (int k = 0; k < 4; k++)
+        {
+            promoCompIdx[p][k] = -1;
+        }
+    }
+}
+
+// Build the instances from the chess components and their target specs
+// Inputs: Chess components, target Model matrix specs
+// Output: None
+void chessBoard::setupPieces(std::vector<chessComponent>& components, tModelMap& cTModelMap)
+{
+    pieces.clear();
+    // Board plus 32 pieces
+    pieces.reserve(33);
+
+    const nameTable& names = getComponentNames();
+    for (unsigned int cIdx = 0; cIdx < components.size(); cIdx++)
+    {
+        auto mit = cTModelMap.find(components[cIdx].getComponentID());
+        // Components without a target spec are not rendered
+        if (mit == cTModelMap.end())
+        {
+            continue;
+        }
+
+        // Piece kinds come from the names (once per setup)
+        const std::string& cName = names.getName(mit->first);
+
+        // Record the promotion targets
+        for (int p = 0; p < 2; p++)
+        {
+            for (int k = 0; k < 4; k++)
+            {
+                if (cName == PROMO_NAMES[p][k])
+                {
+                    promoCompIdx[p][k] = cIdx;
+                    promoTPosition[p][k] = mit->second;
+                }
+            }
+        }
+
+        // Repeat for pair of players using repetition count
+        for (unsigned int pit = 0; pit < mit->second.rCnt; pit++)
+        {
+            pieceInstanceT piece;
+            piece.compIdx = cIdx;
+            piece.cTPosition = mit->second;
+            piece.cTPosition.tPos.x += pit * mit->second.rDis * CHESS_BOX_SIZE;
+            piece.captured = false;
+            piece.captureSlot = 0;
+            piece.promoKind = -1;
+            piece.isPawn = (cName.compare(0, 6, "PEDONE") == 0);
+            piece.isKing = (cName == "RE2" || cName == "RE01");
+
+            if (cName == CBOARD_NAME)
+            { // The board itself is not on a square
+                piece.file = -1;
+                piece.rank = -1;
+                piece.isWhite = false;
+            }
+            else
+            { // Snap the resting position to its square
+                piece.file = static_cast<int>(std::lround(piece.cTPosition.tPos.x / CHESS_BOX_SIZE + 3.5f));
+                piece.rank = static_cast<int>(std::lround(piece.cTPosition.tPos.y / CHESS_BOX_SIZE + 3.5f));
+                piece.isWhite = (piece.rank < 4);
+                squares[piece.file][piece.rank] = static_cast<int>(pieces.size());
+            }
+            pieces.push_back(piece);
+        }
+    }
+    initialPieces = pieces;
+    whiteToMove = true;
+    epFile = -1;
+}
+
+// Put every piece back on its start square
+// Inputs: None
+// Output: None
+void chessBoard::resetPieces()
+{
+    pieces = initialPieces;
+    for (int f = 0; f < 8; f++)
+    {
+        for (int r = 0; r < 8; r++)
+        {
+            squares[f][r] = -1;
+        }
+    }
+    for (unsigned int pIdx = 0; pIdx < pieces.size(); pIdx++)
+    {
+        if (pieces[pIdx].file >= 0)
+        {
+            squares[pieces[pIdx].file][pieces[pIdx].rank] = static_cast<int>(pIdx);
+        }
+    }
+    capturedCnt[0] = 0;
+    capturedCnt[1] = 0;
+    whiteToMove = true;
+    epFile = -1;
+}
+
+// Save the position of every instance
+// Inputs: state to fill
+// Output: false if there are too many instances to save
+bool chessBoard::saveState(boardStateT& state) const
+{
+    if (pieces.size() > BOARD_STATE_PIECES)
+    {
+        return false;
+    }
+    for (unsigned int pIdx = 0; pIdx < BOARD_STATE_PIECES; pIdx++)
+    {
+        state.square[pIdx] = BOARD_STATE_OFF;
+        state.promo[pIdx] = 0;
+        if (pIdx >= pieces.size())
+        {
+            continue;
+        }
+        const pieceInstanceT& piece = pieces[pIdx];
+        if (piece.captured)
+        {
+            state.square[pIdx] = BOARD_STATE_CAPTURED | static_cast<uint8_t>(piece.captureSlot);
+        }
+        else if (piece.file >= 0)
+        {
+            state.square[pIdx] = static_cast<uint8_t>(piece.file * 8 + piece.rank);
+        }
+        state.promo[pIdx] = static_cast<uint8_t>(piece.promoKind + 1);
+    }
+    state.whiteToMove = whiteToMove ? 1 : 0;
+    state.epFile = (epFile >= 0) ? static_cast<uint8_t>(epFile) : BOARD_STATE_OFF;
+    return true;
+}
+
+// Restore a saved position (the board is left untouched if it is invalid)
+// Inputs: saved state
+// Output: true if the position was restored
+bool chessBoard::loadState(const boardStateT& state)
+{
+    if (initialPieces.size() > BOARD_STATE_PIECES)
+    {
+        return false;
+    }
+
+    // Validate first: pieces stay pieces, one per square, known promotions
+    if (state.whiteToMove > 1 || (state.epFile != BOARD_STATE_OFF && state.epFile >= 8))
+    {
+        return false;
+    }
+    bool used[64] = {};
+    for (unsigned int pIdx = 0; pIdx < initialPieces.size(); pIdx++)
+    {
+        const pieceInstanceT& piece = initialPieces[pIdx];
+        uint8_t sq = state.square[pIdx];
+        uint8_t promo = state.promo[pIdx];
+        if (piece.file < 0)
+        {
+            if (sq != BOARD_STATE_OFF || promo != 0)
+            {
+                return false;
+            }
+            continue;
+        }
+        if (sq == BOARD_STATE_OFF || sq >= 2 * BOARD_STATE_CAPTURED)
+        {
+            return false;
+        }
+        if ((sq & BOARD_STATE_CAPTURED) == 0)
+        {
+            if (used[sq])
+            {
+                return false;
+            }
+            used[sq] = true;
+        }
+        if (promo > 4 || (promo > 0 && (!piece.isPawn || promoCompIdx[piece.isWhite ? 1 : 0][promo - 1] < 0)))
+        {
+            return false;
+        }
+    }
+
+    // Rebuild the board from the start instances
+    pieces = initialPieces;
+    capturedCnt[0] = 0;
+    capturedCnt[1] = 0;
+    whiteToMove = (state.whiteToMove != 0);
+    epFile = (state.epFile != BOARD_STATE_OFF) ? state.epFile : -1;
+    for (int f = 0; f < 8; f++)
+    {
+        for (int r = 0; r < 8; r++)
+        {
+            squares[f][r] = -1;
+        }
+    }
+    for (unsigned int pIdx = 0; pIdx < pieces.size(); pIdx++)
+    {
+        pieceInstanceT& piece = pieces[pIdx];
+        uint8_t sq = state.square[pIdx];
+        if (sq == BOARD_STATE_OFF)
+        {
+            continue;
+        }
+        if (state.promo[pIdx] > 0)
+        {
+            promotePiece(pIdx, state.promo[pIdx] - 1);
+        }
+        if (sq & BOARD_STATE_CAPTURED)
+        {
+            unsigned int player = piece.isWhite ? 1 : 0;
+            unsigned int slot = sq & (BOARD_STATE_CAPTURED - 1);
+            lineUpPiece(piece, slot);
+            capturedCnt[player] = (slot + 1 > capturedCnt[player]) ? slot + 1 : capturedCnt[player];
+        }
+        else
+        {
+            piece.file = sq / 8;
+            piece.rank = sq % 8;
+            piece.cTPosition.tPos = squarePosition(piece.file, piece.rank);
+            squares[piece.file][piece.rank] = static_cast<int>(pIdx);
+        }
+    }
+    return true;
+}
+
+// Apply a move in long algebraic notation ("e2e4", "e7e8q")
+// Inputs: move string
+// Output: true if the move was applied, result describes the changes
+bool chessBoard::applyMove(std::string_view move, moveResultT& result)
+{
+    int fromFile, fromRank, toFile, toRank;
+
+    result.movedPiece = -1;
+    result.capturedPiece = -1;
+    result.rookPiece = -1;
+    result.promoted = false;
+
+    // Validate the move format
+    if (move.size() < 4 || move.size() > 5 ||
+        !parseSquare(&move[0], fromFile, fromRank) ||
+        !parseSquare(&move[2], toFile, toRank))
+    {
+        return false;
+    }
+    int pIdx = squares[fromFile][fromRank];
+    if (pIdx < 0 || (fromFile == toFile && fromRank == toRank))
+    {
+        return false;
+    }
+    pieceInstanceT& piece = pieces[pIdx];
+    if (piece.isWhite != whiteToMove)
+    {
+        return false;
+    }
+
+    // Regular capture (never an own piece)
+    int victim = squares[toFile][toRank];
+    if (victim >= 0 && pieces[victim].isWhite == piece.isWhite)
+    {
+        return false;
+    }
+    // A pawn moving diagonally to an empty square only captures en passant:
+    // the enemy pawn beside it must have moved two squares on the last ply
+    if (victim < 0 && piece.isPawn && fromFile != toFile)
+    {
+        victim = squares[toFile][fromRank];
+        if (toFile != epFile || toRank != (piece.isWhite ? 5 : 2) || victim < 0 ||
+            !pieces[victim].isPawn || pieces[victim].isWhite == piece.isWhite)
+        {
+            return false;
+        }
+    }
+
+    // Castling (king moving two files drags its own corner rook along)
+    int rIdx = -1;
+    int rookTo = 0;
+    if (piece.isKing && std::abs(toFile - fromFile) == 2)
+    {
+        int rookFrom = (toFile > fromFile) ? 7 : 0;
+        rookTo = (toFile > fromFile) ? 5 : 3;
+        rIdx = squares[rookFrom][fromRank];
+        if (toRank != fromRank || rIdx < 0 || pieces[rIdx].isWhite != piece.isWhite)
+        {
+            return false;
+        }
+    }
+
+    // Checked, apply it
+    if (victim >= 0)
+    {
+        capturePiece(victim);
+        result.capturedPiece = victim;
+    }
+    if (rIdx >= 0)
+    {
+        placePiece(rIdx, rookTo, fromRank);
+        result.rookPiece = rIdx;
+    }
+    placePiece(pIdx, toFile, toRank);
+    result.movedPiece = pIdx;
+    epFile = (piece.isPawn && std::abs(toRank - fromRank) == 2) ? fromFile : -1;
+    whiteToMove = !whiteToMove;
+
+    // Promotion (defaults to a queen)
+    if (piece.isPawn && (toRank == 0 || toRank == 7))
+    {
+        int kind = 0;
+        for (int k = 0; k < 4 && move.size() == 5; k++)
+        {
+            if (move[4] == PROMO_LETTERS[k])
+            {
+                kind = k;
+            }
+        }
+        result.promoted = promotePiece(pIdx, kind);
+    }
+
+    return true;
+}
+
+// World position of a square (centre, on the platform)
+// Inputs: file and rank
+// Output: World position
+glm::vec3 chessBoard::squarePosition(int file, int rank) const
+{
+    return glm::vec3((file - 3.5f) * CHESS_BOX_SIZE, (rank - 3.5f) * CHESS_BOX_SIZE, PHEIGHT);
+}
+
+// Get the number of instances
+// Inputs: None
+// Output: Instance count
+unsigned int chessBoard::getPieceCount() const
+{
+    return static_cast<unsigned int>(pieces.size());
+}
+
+// Get an instance
+// Inputs: instance index
+// Output: instance
+const pieceInstanceT& chessBoard::getPiece(unsigned int pIdx) const
+{
+    return pieces[pIdx];
+}
@@ -0,0 +1,137 @@
+/*
+Objective:
+Chess board state header file
+*/
+
+#ifndef CHESS_BOARD_H
+#define CHESS_BOARD_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "chessCommon.h"
+#include "chessComponent.h"
+
+// Include GLM
+#include <glm/glm.hpp>
+
+// Chess board component name (not a piece, never moves)
+const std::string CBOARD_NAME = "12951_Stone_Chess_Board";
+
+// A single rendered copy of a chess component
+typedef struct
+{
+    unsigned int compIdx;      // Index into the chess component vector
+    tPosition cTPosition;      // Model matrix spec (tPos is the resting position)
+    int file;                  // 0..7 (a..h), -1 when not on a square
+    int rank;                  // 0..7 (1..8), -1 when not on a square
+    bool isWhite;              // First player pieces
+    bool isPawn;               // Pawns promote and capture en passant
+    bool isKing;               // Kings castle
+    bool captured;             // Moved off the board
+    unsigned int captureSlot;  // Place in the owner's line of captured pieces
+    int promoKind;             // Promotion piece (queen, rook, bishop, knight), -1 if none
+} pieceInstanceT;
+
+// Largest instance count a saved position can hold (board plus 32 pieces fit)
+const unsigned int BOARD_STATE_PIECES = 35;
+// Saved square values besides file * 8 + rank
+const uint8_t BOARD_STATE_OFF = 0xFF;           // Not on a square (the board itself)
+const uint8_t BOARD_STATE_CAPTURED = 0x40;      // Captured, low bits are the capture slot
+
+// Compact position of every instance (fixed size, written as is to the game journal)
+typedef struct
+{
+    uint8_t square[BOARD_STATE_PIECES];         // Square, capture slot or off
+    uint8_t promo[BOARD_STATE_PIECES];          // Promotion kind + 1, 0 if not promoted
+    uint8_t whiteToMove;                        // 1 if the first player moves next
+    uint8_t epFile;                             // File of a pawn that just moved two squares, or off
+} boardStateT;
+
+// Outcome of a move, used to drive the animations
+typedef struct
+{
+    int movedPiece;            // Instance index of the moving piece
+    int capturedPiece;         // Instance index of the captured piece (-1 if none)
+    int rookPiece;             // Instance index of the castling rook (-1 if none)
+    bool promoted;             // Moving pawn was promoted
+} moveResultT;
+
+class chessBoard
+{
+private:
+    // All the rendered instances (board and pieces)
+    std::vector<pieceInstanceT> pieces;
+    // Instances as set up (start position)
+    std::vector<pieceInstanceT> initialPieces;
+    // Square occupancy [file][rank] -> instance index (-1 when empty)
+    int squares[8][8];
+    // Captured pieces count per player (to line them up next to the board)
+    unsigned int capturedCnt[2];
+    // Side to move
+    bool whiteToMove;
+    // File of the pawn that moved two squares on the last ply (-1 if none)
+    int epFile;
+    // Promotion targets per player (queen, rook, bishop, knight)
+    int promoCompIdx[2][4];
+    tPosition promoTPosition[2][4];
+
+    // Parse a square name ("e2")
+    // Inputs: square characters
+    // Output: true if the square is valid
+    bool parseSquare(const char* sq, int& file, int& rank) const;
+    // Move a piece off the board
+    // Inputs: instance index
+    // Output: None
+    void capturePiece(int pIdx);
+    // Move a piece to a square
+    // Inputs: instance index and target square
+    // Output: None
+    void placePiece(int pIdx, int file, int rank);
+    // Swap a pawn for a promotion piece (keeps its position)
+    // Inputs: instance index, promotion kind
+    // Output: true if the promotion piece exists
+    bool promotePiece(int pIdx, int kind);
+
+public:
+    // Constructor function
+    chessBoard();
+    // Build the instances from the chess components and their target specs
+    // Inputs: Chess components, target Model matrix specs
+    // Output: None
+    void setupPieces(std::vector<chessComponent>& components, tModelMap& cTModelMap);
+    // Put every piece back on its start square
+    // Inputs: None
+    // Output: None
+    void resetPieces();
+    // Save the position of every instance
+    // Inputs: state to fill
+    // Output: false if there are too many instances to save
+    bool saveState(boardStateT& state) const;
+    // Restore a saved position (the board is left untouched if it is invalid)
+    // Inputs: saved state
+    // Output: true if the position was restored
+    bool loadState(const boardStateT& state);
+    // Apply a move in long algebraic notation ("e2e4", "e7e8q"). Moves out of
+    // turn, onto an own piece, and diagonal pawn moves to an empty square other
+    // than an en passant capture are rejected (the rest is left to the engine).
+    // Inputs: move string
+    // Output: true if the move was applied (the board is untouched otherwise),
+    //         result describes the changes
+    bool applyMove(std::string_view move, moveResultT& result);
+    // World position of a square (centre, on the platform)
+    // Inputs: file and rank
+    // Output: World position
+    glm::vec3 squarePosition(int file, int rank) const;
+    // Get the number of instances
+    // Inputs: None
+    // Output: Instance count
+    unsigned int getPieceCount() const;
+    // Get an instance
+    // Inputs: instance index
+    // Output: instance
+    const pieceInstanceT& getPiece(unsigned int pIdx) const;
+};
+
+#endif
@@ -46,6 +46,7 @@ const float CPSCALE = 0.015f;
 // Platform height
 const float PHEIGHT = -3.0f;
 // Hash to hold the target Model matrix spec for each Chess component
-typedef std::unordered_map <std::string, tPosition> tModelMap;
+// (keyed by the interned component name, see getComponentNames)
+typedef std::unordered_map <unsigned int, tPosition> tModelMap;
 
 #endif
@@ -5,49 +5,45 @@ Chess component class definition file
 */
 
 #include "chessComponent.h"
+#include <algorithm>
 
 
-// Compute the Geometric center
+// Compute the Geometric center, bounds and bounding sphere, fix up the normals
 // Inputs: None
 // Output: None
-void chessComponent::getGeometricCenter()
+void chessComponent::preprocessMesh()
 {
-    // Reset the geometric center
-    cGeometricCener = glm::vec3(0.0f);
-    
-    //Sum all vertices
-    for (const auto& vertex : vertices)
+    meshSpan<const glm::vec3> meshVertices = getVertices();
+    meshSpan<const unsigned short> meshIndices = getIndices();
+
+    // Geometric center and bounding box in one pass (zero for an empty mesh)
+    meshBoundsT bounds = computeCentroidBounds(meshVertices);
+    cGeometricCener = bounds.centroid;
+    cBoundingLimitsMin = bounds.bMin;
+    cBoundingLimitsMax = bounds.bMax;
+    cBoundingSphere = computeBoundingSphere(meshVertices, bounds);
+
+    // Normals must pair up with the vertices, rebuild them from the faces
+    // otherwise (meshes exported without normals take this path every load)
+    std::vector<glm::vec3> faceNormals;
+    if (normalCnt != vertexCnt)
     {
-        cGeometricCener.x += vertex.x;
-        cGeometricCener.y += vertex.y;
-        cGeometricCener.z += vertex.z;
-    }
-    // Compute Average
-    if (vertices.size() > 0)
-    { // Divide-by-zero protection
-        cGeometricCener = cGeometricCener / static_cast<float> (vertices.size());
-    }
-    else
-    { // No Vertices (Weird case)
-        cGeometricCener = glm::vec3(0.0f);
+        computeNormals(meshVertices, meshIndices, faceNormals);
+        std::copy(faceNormals.begin(), faceNormals.end(), normals.begin());
+        normalCnt = vertexCnt;
+        return;
     }
-}
-
-// Compute the Bounding box
-// Inputs: None
-// Output: None
-void chessComponent::getBoundingBox()
-{
-    // Initialize the min and max
-    cBoundingLimitsMin = vertices.front();
-    cBoundingLimitsMax = vertices.front();
-
-    // Finding min and max iterating over
-    // all vertices
-    for (const auto& vertex : vertices)
+    // Exported normals are not always unit length, zero ones take the face normals
+    if (renormalizeNormals(meshSpan<glm::vec3>(normals.data(), normalCnt)) > 0)
     {
-        cBoundingLimitsMin = glm::min(cBoundingLimitsMin, vertex);
-        cBoundingLimitsMax = glm::max(cBoundingLimitsMax, vertex);
+        computeNormals(meshVertices, meshIndices, faceNormals);
+        for (std::size_t i = 0; i < normalCnt; i++)
+        {
+            if (glm::dot(normals[i], normals[i]) <= MESH_MIN_LENGTH2)
+            {
+                normals[i] = faceNormals[i];
+            }
+        }
     }
 }
 
@@ -64,29 +60,16 @@ chessComponent::chessComponent()
     meshProps.hasVertexColors = false;
     meshProps.numOfUVChannels = 0;
 
-    // Clear the vertice, normals, uv buffer vectors
-    indices.clear();
-    vertices.clear();
-    uvs.clear();
-    normals.clear();
-
-    // OpenGL Buffers management
-    vertexbuffer = 0;
-    uvbuffer = 0;
-    normalbuffer = 0;
-    elementbuffer = 0;
-
     // Component ID
-    cName = "";
+    cID = 0;
+    isBoard = false;
+    flipOnRotate = false;
     cTextureFile = "";
 
     // Reset the geometric center
     cGeometricCener = glm::vec3(0.0f);
     cBoundingLimitsMin = glm::vec3(0.0f);
-    cBoundingLimitsMin = glm::vec3(0.0f);
-
-    // Reset the Texture handle
-    Texture = 0;
+    cBoundingLimitsMax = glm::vec3(0.0f);
 }
 
 // Destructor function
@@ -96,19 +79,76 @@ chessComponent::~chessComponent()
     deleteGLBuffers();
 }
 
+// Move constructor (GL objects change owner, the source is left empty)
+chessComponent::chessComponent(chessComponent&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+// Move assignment (our own GL objects are deleted first)
+chessComponent& chessComponent::operator=(chessComponent&& other) noexcept
+{
+    if (this == &other)
+    {
+        return *this;
+    }
+    deleteGLBuffers();
+
+    // Mesh views (the arena keeps the data)
+    indices = other.indices;
+    vertices = other.vertices;
+    uvs = other.uvs;
+    normals = other.normals;
+    indexCnt = other.indexCnt;
+    vertexCnt = other.vertexCnt;
+    uvCnt = other.uvCnt;
+    normalCnt = other.normalCnt;
+    other.releaseMeshData();
+
+    // GL objects
+    vertexbuffer = other.vertexbuffer;
+    uvbuffer = other.uvbuffer;
+    normalbuffer = other.normalbuffer;
+    elementbuffer = other.elementbuffer;
+    elementCnt = other.elementCnt;
+    Texture = other.Texture;
+    other.vertexbuffer = 0;
+    other.uvbuffer = 0;
+    other.normalbuffer = 0;
+    other.elementbuffer = 0;
+    other.elementCnt = 0;
+    other.Texture = 0;
+
+    // Component ID and mesh properties
+    cID = other.cID;
+    isBoard = other.isBoard;
+    flipOnRotate = other.flipOnRotate;
+    cTextureFile = std::move(other.cTextureFile);
+    meshProps = other.meshProps;
+    cGeometricCener = other.cGeometricCener;
+    cBoundingLimitsMin = other.cBoundingLimitsMin;
+    cBoundingLimitsMax = other.cBoundingLimitsMax;
+    cBoundingSphere = other.cBoundingSphere;
+    return *this;
+}
+
 // Reserve storage
-// Inputs: memory limits for performance
-// Output: None
-void chessComponent::reserveStorage(const unsigned int& vCapacity, const unsigned int& fCapacity)
+// Inputs: mesh arena, memory limits (extra entries are dropped)
+// Output: true if the arena had room
+bool chessComponent::reserveStorage(meshArena& arena, const unsigned int& vCapacity, const unsigned int& fCapacity)
 {
-    // Reserve Vertex storage capcity
-    vertices.reserve(vCapacity);
-    // Reserve Texture coordinates capacity
-    uvs.reserve(vCapacity);
-    // Reserve normal capacity
-    normals.reserve(vCapacity);
-    // Reserved face capacity
-    indices.reserve(3U*fCapacity);
+    // Vertex, texture coordinate and normal storage
+    vertices = arena.allocate<glm::vec3>(vCapacity);
+    uvs = arena.allocate<glm::vec2>(vCapacity);
+    normals = arena.allocate<glm::vec3>(vCapacity);
+    // Face storage
+    indices = arena.allocate<unsigned short>(3U*fCapacity);
+    indexCnt = 0;
+    vertexCnt = 0;
+    uvCnt = 0;
+    normalCnt = 0;
+    return vertices.size() == vCapacity && uvs.size() == vCapacity &&
+           normals.size() == vCapacity && indices.size() == 3U*fCapacity;
 }
 
 // Add vertices
@@ -117,7 +157,10 @@ void chessComponent::reserveStorage(const unsigned int& vCapacity, const unsigne
 void chessComponent::addVertices(glm::vec3& objVertice)
 {
     // Add a vertice
-    vertices.push_back(objVertice);
+    if (vertexCnt < vertices.size())
+    {
+        vertices[vertexCnt++] = objVertice;
+    }
 }
 
 // Add Texture Coordinates
@@ -126,7 +169,10 @@ void chessComponent::addVertices(glm::vec3& objVertice)
 void chessComponent::addTextureCor(glm::vec3& objUVW)
 {
     // Add the texture coordinate
-    uvs.push_back(glm::vec2(objUVW.x, objUVW.y));
+    if (uvCnt < uvs.size())
+    {
+        uvs[uvCnt++] = glm::vec2(objUVW.x, objUVW.y);
+    }
 }
 
 // Add Vertices Normals
@@ -135,7 +181,10 @@ void chessComponent::addTextureCor(glm::vec3& objUVW)
 void chessComponent::addVerNormals(glm::vec3& objVerNormal)
 {
     // Fill vertices normals
-    normals.push_back(objVerNormal);
+    if (normalCnt < normals.size())
+    {
+        normals[normalCnt++] = objVerNormal;
+    }
 }
 
 // Add Face indices
@@ -145,9 +194,28 @@ void chessComponent::addFaceIndices(unsigned int *objFaceIndice)
 {
     // Fill face indices
     // Assume the model has only triangles.
-    indices.push_back(objFaceIndice[0]);
-    indices.push_back(objFaceIndice[1]);
-    indices.push_back(objFaceIndice[2]);
+    if (indexCnt + 3 <= indices.size())
+    {
+        indices[indexCnt++] = static_cast<unsigned short>(objFaceIndice[0]);
+        indices[indexCnt++] = static_cast<unsigned short>(objFaceIndice[1]);
+        indices[indexCnt++] = static_cast<unsigned short>(objFaceIndice[2]);
+    }
+}
+
+// Fill the whole mesh at once
+// Inputs: positions, texture coordinates, normals, triangle indices
+// Output: None
+void chessComponent::fillMesh(const glm::vec3* meshVertices, const glm::vec2* meshUvs, const glm::vec3* meshNormals,
+                              const unsigned short* meshIndices)
+{
+    vertexCnt = static_cast<unsigned int>(vertices.size());
+    std::copy(meshVertices, meshVertices + vertexCnt, vertices.begin());
+    uvCnt = (meshUvs != nullptr) ? static_cast<unsigned int>(uvs.size()) : 0;
+    std::copy(meshUvs, meshUvs + uvCnt, uvs.begin());
+    normalCnt = (meshNormals != nullptr) ? static_cast<unsigned int>(normals.size()) : 0;
+    std::copy(meshNormals, meshNormals + normalCnt, normals.begin());
+    indexCnt = static_cast<unsigned int>(indices.size());
+    std::copy(meshIndices, meshIndices + indexCnt, indices.begin());
 }
 
 // Setup rendering buffers
@@ -155,29 +223,44 @@ void chessComponent::addFaceIndices(unsigned int *objFaceIndice)
 // Output: None
 void chessComponent::setupGLBuffers()
 {
+    // Bounds and normals before the upload
+    preprocessMesh();
+
     // Load it into a VBO
     glGenBuffers(1, &vertexbuffer);
     glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec3), &vertices[0], GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, vertexCnt * sizeof(glm::vec3), vertices.data(), GL_STATIC_DRAW);
     
     // Load it into UV Buffer
     glGenBuffers(1, &uvbuffer);
     glBindBuffer(GL_ARRAY_BUFFER, uvbuffer);
-    glBufferData(GL_ARRAY_BUFFER, uvs.size() * sizeof(glm::vec2), &uvs[0], GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, uvCnt * sizeof(glm::vec2), uvs.data(), GL_STATIC_DRAW);
     
     // Load it into the normals buffer
     glGenBuffers(1, &normalbuffer);
     glBindBuffer(GL_ARRAY_BUFFER, normalbuffer);
-    glBufferData(GL_ARRAY_BUFFER, normals.size() * sizeof(glm::vec3), &normals[0], GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, normalCnt * sizeof(glm::vec3), normals.data(), GL_STATIC_DRAW);
 
     // Generate a buffer for the indices as well
     glGenBuffers(1, &elementbuffer);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementbuffer);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned short), &indices[0], GL_STATIC_DRAW);
-
-    // Compute the Geometric center
-    getGeometricCenter();
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCnt * sizeof(unsigned short), indices.data(), GL_STATIC_DRAW);
+    elementCnt = static_cast<GLsizei>(indexCnt);
+}
 
+// Drop the mesh data (before the arena holding it is released)
+// Inputs: None
+// Output: None
+void chessComponent::releaseMeshData()
+{
+    indices = meshSpan<unsigned short>();
+    vertices = meshSpan<glm::vec3>();
+    uvs = meshSpan<glm::vec2>();
+    normals = meshSpan<glm::vec3>();
+    indexCnt = 0;
+    vertexCnt = 0;
+    uvCnt = 0;
+    normalCnt = 0;
 }
 
 // Setup Texture buffers
@@ -193,50 +276,33 @@ void chessComponent::setupTexture(GLuint& TextureID)
 }
 
 // Setup rendering buffers
-// Inputs: None
+// Inputs: Cooked asset bundle (BMP file when the texture is not in it)
 // Output: None
-void chessComponent::setupTextureBuffers()
+void chessComponent::setupTextureBuffers(const assetBundle& bundle)
 {
-    // Matching pattern and rule creation
-    // Any combination of 0-9, space in the beginning or end is allowed!
-    // Discarded while converting to integer
-    std::string regexPattern = "\\s*([\\w0-9]+)\\.\\s*";  // Pattern       
-    std::regex  regexRule(regexPattern);                  // Create a custom search rule
-    // Match string
-    std::smatch matches;
-
-    // Perform search on the Texture file name search
-    if (std::regex_search(cTextureFile, matches, regexRule))
+    if (cTextureFile.empty())
     {
-        // Update the Texture file name (since we only support bmps)
-        cTextureFile = matches[1].str();
-        // Process directory path, it's a short cut for now!
-        if (cTextureFile == "12951_Stone_Chess_Board_diff")
-        { // Chess board directory path
-            cTextureFile = "Lab3/Stone_Chess_Board/" + cTextureFile;
-        }
-        else
-        { // Chess pieces directory path
-            cTextureFile = "Lab3/Chess/" + cTextureFile;
-        }
-        // Add the bmp extension
-        cTextureFile += ".bmp";
-        // Test print
-        // std::cout << "Texture file is " << cTextureFile << std::endl;
+        std::cout << "Texture file not found for chess compoent!" << getComponentNames().getName(cID) << std::endl;
+        return;
     }
-    else
+    // Cooked texture (compressed mip chain, no decoding), named by the file stem
+    std::string_view stem = cTextureFile;
+    stem = stem.substr(stem.find_last_of('/') + 1);
+    stem = stem.substr(0, stem.find_last_of('.'));
+    Texture = bundle.loadTexture(stem);
+    if (Texture != 0)
     {
-        std::cout << "Texture file not found for chess compoent!" << cName << std::endl;
+        return;
     }
 
     // Load the texture
-    Texture = loadBMP_custom(&cTextureFile[0]);
+    Texture = loadBMP_custom(cTextureFile.c_str());
 }
 
-// Render a mesh
-// Inputs: None
+// Render a mesh (instanced, one model matrix per instance)
+// Inputs: instance matrix buffer, first instance, instance count
 // Output: None
-void chessComponent::renderMesh()
+void chessComponent::renderMesh(GLuint instanceBuffer, unsigned int first, unsigned int count)
 {
     // 1rst attribute buffer : vertices
     glEnableVertexAttribArray(0);
@@ -274,21 +340,43 @@ void chessComponent::renderMesh()
         (void*)0                          // array buffer offset
     );
 
+    // 4th-7th attribute buffers : per instance model matrix (one column each)
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    for (GLuint col = 0; col < 4; col++)
+    {
+        glEnableVertexAttribArray(3 + col);
+        glVertexAttribPointer(
+            3 + col,                          // attribute
+            4,                                // size
+            GL_FLOAT,                         // type
+            GL_FALSE,                         // normalized?
+            sizeof(glm::mat4),                // stride
+            (void*)(first * sizeof(glm::mat4) + col * sizeof(glm::vec4)) // array buffer offset
+        );
+        glVertexAttribDivisor(3 + col, 1);
+    }
+
     // Index buffer
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementbuffer);
 
-    // Draw the triangles !
-    glDrawElements(
+    // Draw the triangles of every instance !
+    glDrawElementsInstanced(
         GL_TRIANGLES,      // mode
-        indices.size(),    // count
+        elementCnt,        // count
         GL_UNSIGNED_SHORT,   // type
-        (void*)0           // element array buffer offset
+        (void*)0,          // element array buffer offset
+        count              // instance count
     );
 
     // Disable the arrays
     glDisableVertexAttribArray(0);
     glDisableVertexAttribArray(1);
     glDisableVertexAttribArray(2);
+    for (GLuint col = 0; col < 4; col++)
+    {
+        glVertexAttribDivisor(3 + col, 0);
+        glDisableVertexAttribArray(3 + col);
+    }
 }
 
 // Render a mesh
@@ -296,30 +384,45 @@ void chessComponent::renderMesh()
 // Output: None
 void chessComponent::deleteGLBuffers()
 {
-    // Cleanup VBO
-    glDeleteBuffers(1, &vertexbuffer);
-    glDeleteBuffers(1, &uvbuffer);
-    glDeleteBuffers(1, &normalbuffer);
-    glDeleteBuffers(1, &elementbuffer);
+    // Cleanup VBO (nothing to do once moved from)
+    if (vertexbuffer != 0)
+    {
+        glDeleteBuffers(1, &vertexbuffer);
+        glDeleteBuffers(1, &uvbuffer);
+        glDeleteBuffers(1, &normalbuffer);
+        glDeleteBuffers(1, &elementbuffer);
+    }
     // Cleanup Texture buffer
-    glDeleteTextures(1, &Texture);
+    if (Texture != 0)
+    {
+        glDeleteTextures(1, &Texture);
+    }
+    vertexbuffer = 0;
+    uvbuffer = 0;
+    normalbuffer = 0;
+    elementbuffer = 0;
+    elementCnt = 0;
+    Texture = 0;
 }
 
 // Stores a component ID
-// Inputs: None
+// Inputs: Component name (interned)
 // Output: None
-void chessComponent::storeComponentID(std::string cName)
+void chessComponent::storeComponentID(std::string_view cName)
 {
     // Capture the component name
-    this->cName = cName;
+    cID = getComponentNames().intern(cName);
+    // Model matrix adjustments, decided once rather than per frame
+    isBoard = (cName == "12951_Stone_Chess_Board");
+    flipOnRotate = (cName == "Object3" || cName == "ALFIERE3");
     // Testing
-    // std::cout << "The child name is " << this->cName << std::endl;
+    // std::cout << "The child name is " << cName << std::endl;
 }
 
 // Stores a Texture file name
 // Inputs: None
 // Output: None
-void chessComponent::storeTextureID(std::string cTextureFile)
+void chessComponent::storeTextureID(std::string_view cTextureFile)
 {
     // Capture the component name
     this->cTextureFile = cTextureFile;
@@ -348,7 +451,7 @@ glm::mat4 chessComponent::genModelMatrix(tPosition& cTPosition)
     if (cTPosition.rAngle != 0.f)
     {
         // Rotate Knight/Bishop by another 180 degree aroudn Z
-        if (cName == "Object3" || cName == "ALFIERE3")
+        if (flipOnRotate)
         {
             tModel = glm::rotate(tModel, glm::radians(180.f), {0, 0, 1});
         }
@@ -360,7 +463,7 @@ glm::mat4 chessComponent::genModelMatrix(tPosition& cTPosition)
     // tModel = glm::translate(tModel, -cGeometricCener);
     // We want the board surface to be in the X/Z plane. Need to move in -y direction
     // equal to board's height.
-    if (cName == "12951_Stone_Chess_Board")
+    if (isBoard)
     { // For Chess board eliminate the height by pushing it down by the height
         // Apply the adjustment (Z is compensated to push the board down by depth)
         tModel = glm::translate(tModel, {-cGeometricCener.x, -cGeometricCener.y, -cGeometricCener.z/2});
@@ -376,7 +479,31 @@ glm::mat4 chessComponent::genModelMatrix(tPosition& cTPosition)
 // Get ID
 // Inputs: None
 // Output: ID
-std::string chessComponent::getComponentID()
+unsigned int chessComponent::getComponentID() const
+{
+    return cID;
+}
+
+// Get the mesh vertices (model space, empty once dropped)
+// Inputs: None
+// Output: vertices
+meshSpan<const glm::vec3> chessComponent::getVertices() const
+{
+    return meshSpan<const glm::vec3>(vertices.data(), vertexCnt);
+}
+
+// Get the mesh triangle indices (empty once dropped)
+// Inputs: None
+// Output: indices
+meshSpan<const unsigned short> chessComponent::getIndices() const
+{
+    return meshSpan<const unsigned short>(indices.data(), indexCnt);
+}
+
+// Get the bounding sphere (model space)
+// Inputs: None
+// Output: bounding sphere
+const boundingSphereT& chessComponent::getBoundingSphere() const
 {
-    return cName;
+    return cBoundingSphere;
 }
@@ -8,8 +8,8 @@ Chess component class header file
 
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <regex>
 #include "chessCommon.h"
 
 // Include GLM
@@ -20,25 +20,43 @@ Chess component class header file
 
 // Load BMP function support
 #include <common/texture.hpp>
+// Cooked texture support
+#include "asset_bundle.hpp"
+// Load time geometry kernels
+#include "mesh_preprocess.hpp"
+// Mesh storage and interned names
+#include "mesh_arena.hpp"
+#include "name_table.hpp"
 
+// Move only: a component owns its GL buffers and texture, copies would
+// delete them twice
 class chessComponent
 {
 private:
     // Properties of a Chess component
-    // mesh
-    std::vector<unsigned short> indices;
-    std::vector<glm::vec3> vertices;
-    std::vector<glm::vec2> uvs;
-    std::vector<glm::vec3> normals;
+    // mesh (arrays in the scene's mesh arena, dropped once on the GPU)
+    meshSpan<unsigned short> indices;
+    meshSpan<glm::vec3> vertices;
+    meshSpan<glm::vec2> uvs;
+    meshSpan<glm::vec3> normals;
+    // Filled entries of the arrays
+    unsigned int indexCnt = 0;
+    unsigned int vertexCnt = 0;
+    unsigned int uvCnt = 0;
+    unsigned int normalCnt = 0;
 
     // OpenGL Buffers management
     GLuint vertexbuffer = 0;
     GLuint uvbuffer = 0;
     GLuint normalbuffer = 0;
     GLuint elementbuffer = 0;
+    // Indices drawn per instance (kept once the mesh data is dropped)
+    GLsizei elementCnt = 0;
 
-    // Component ID
-    std::string cName;
+    // Component ID (interned name) and its model matrix adjustments
+    unsigned int cID = 0;
+    bool isBoard = false;
+    bool flipOnRotate = false;
     std::string cTextureFile;
 
     // Mesh properties
@@ -46,19 +64,15 @@ private:
     glm::vec3 cGeometricCener = { 0, 0, 0 };
     glm::vec3 cBoundingLimitsMin = { 0, 0, 0 };
     glm::vec3 cBoundingLimitsMax = { 0, 0, 0 };
+    boundingSphereT cBoundingSphere = { { 0, 0, 0 }, 0 };
 
     // Texture properties
-    GLuint Texture;
+    GLuint Texture = 0;
 
-    // Compute the Geometric center
+    // Compute the Geometric center, bounds and bounding sphere, fix up the normals
     // Inputs: None
     // Output: None
-    void getGeometricCenter();
-
-    // Compute the Bounding box
-    // Inputs: None
-    // Output: None
-    void getBoundingBox();
+    void preprocessMesh();
 
 
 public:
@@ -66,10 +80,15 @@ public:
     chessComponent();
     // destructor function
     ~chessComponent();
+    // Move functions (GL objects change owner, the source is left empty)
+    chessComponent(chessComponent&& other) noexcept;
+    chessComponent& operator=(chessComponent&& other) noexcept;
+    chessComponent(const chessComponent&) = delete;
+    chessComponent& operator=(const chessComponent&) = delete;
     // Reserve storage
-    // Inputs: memory limits for performance
-    // Output: None
-    void reserveStorage(const unsigned int & vCapacity, const unsigned int & fCapacity);
+    // Inputs: mesh arena, memory limits (extra entries are dropped)
+    // Output: true if the arena had room
+    bool reserveStorage(meshArena& arena, const unsigned int & vCapacity, const unsigned int & fCapacity);
     // Add vertices
     // Inputs: Vertices read from OBJ file
     // Output: None
@@ -86,34 +105,44 @@ public:
     // Inputs: Face vertices read from OBJ file
     // Output: None
     void addFaceIndices(unsigned int *objFaceIndice);
+    // Fill the whole mesh at once (after reserveStorage, the arrays hold as
+    // many entries as were reserved, normals and uvs may be nullptr)
+    // Inputs: positions, texture coordinates, normals, triangle indices
+    // Output: None
+    void fillMesh(const glm::vec3* meshVertices, const glm::vec2* meshUvs, const glm::vec3* meshNormals,
+                  const unsigned short* meshIndices);
     // Setup rendering buffers
     // Inputs: None
     // Output: None
     void setupGLBuffers();
-    // Setup Texture buffers
+    // Drop the mesh data (before the arena holding it is released)
     // Inputs: None
     // Output: None
-    void setupTextureBuffers();
+    void releaseMeshData();
+    // Setup Texture buffers
+    // Inputs: Cooked asset bundle (BMP file when the texture is not in it)
+    // Output: None
+    void setupTextureBuffers(const assetBundle& bundle);
     // Setup rendering buffers
     // Inputs: None
     // Output: None
     void setupTexture(GLuint & TextureID);
-    // Render a mesh
-    // Inputs: None
+    // Render a mesh (instanced, one model matrix per instance)
+    // Inputs: instance matrix buffer, first instance, instance count
     // Output: None
-    void renderMesh();
+    void renderMesh(GLuint instanceBuffer, unsigned int first, unsigned int count);
     // Render a mesh
     // Inputs: None
     // Output: None
     void deleteGLBuffers();
     // Stores a component ID
-    // Inputs: None
+    // Inputs: Component name (interned)
     // Output: None
-    void storeComponentID(std::string cName);
+    void storeComponentID(std::string_view cName);
     // Stores a Texture file name
-    // Inputs: None
+    // Inputs: BMP path (its stem names the cooked texture)
     // Output: None
-    void storeTextureID(std::string cTextureFile);
+    void storeTextureID(std::string_view cTextureFile);
     // Store Mesh properties (mainly for debug and bound checks)
     // Inputs: None
     // Output: None
@@ -124,8 +153,20 @@ public:
     glm::mat4 genModelMatrix(tPosition & cTPosition);
     // Get ID
     // Inputs: None
-    // Output: ID
-    std::string getComponentID();
+    // Output: ID (see getComponentNames for the name)
+    unsigned int getComponentID() const;
+    // Get the mesh vertices (model space, empty once dropped)
+    // Inputs: None
+    // Output: vertices
+    meshSpan<const glm::vec3> getVertices() const;
+    // Get the mesh triangle indices (empty once dropped)
+    // Inputs: None
+    // Output: indices
+    meshSpan<const unsigned short> getIndices() const;
+    // Get the bounding sphere (model space)
+    // Inputs: None
+    // Output: bounding sphere
+    const boundingSphereT& getBoundingSphere() const;
 };
 
 #endif
@@ -0,0 +1,218 @@
+/*
+Objective:
+OBJ loading into chess components (one arena block for all the mesh data, cooked meshes when the asset bundle has them) definition file
+*/
+
+#include <iostream>
+// Include AssImp
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+#include "chessLoader.h"
+
+// Most vertices 16 bit indices can address
+const unsigned int MAX_MESH_VERTICES = 65536;
+
+// Check whether a mesh can be a chess component
+// Inputs: AssImp mesh
+// Output: true for triangle meshes that 16 bit indices can address
+static bool isComponentMesh(const aiMesh* mesh)
+{
+    return mesh->mNumVertices > 0 && mesh->mNumVertices <= MAX_MESH_VERTICES &&
+           (mesh->mPrimitiveTypes & aiPrimitiveType_TRIANGLE) != 0;
+}
+
+// Check whether a cooked mesh can be a chess component
+// Inputs: cooked mesh
+// Output: true for meshes with triangles that 16 bit indices can address
+static bool isComponentMesh(const assetMeshT& mesh)
+{
+    return mesh.header->vertexCount > 0 && mesh.header->vertexCount <= MAX_MESH_VERTICES &&
+           mesh.header->indexCount > 0;
+}
+
+// BMP path of a material texture (the same rule as asset_cook: MTL references
+// are relative to the OBJ file, and name .jpg files that only exist as .bmp)
+// Inputs: OBJ file path, texture reference of the material
+// Output: BMP path
+static std::string resolveTexturePath(const std::string& objFile, std::string_view reference)
+{
+    std::size_t slash = objFile.find_last_of('/');
+    std::string path = (slash == std::string::npos) ? std::string() : objFile.substr(0, slash + 1);
+    std::size_t dot = reference.find_last_of('.');
+    if (dot != std::string_view::npos && (reference.substr(dot) == ".bmp" || reference.substr(dot) == ".BMP"))
+    {
+        return path.append(reference);
+    }
+    std::string_view stem = reference.substr(reference.find_last_of("/\\") + 1);
+    path.append(stem.substr(0, stem.find_last_of('.')));
+    return path + ".bmp";
+}
+
+// Fill a chess component from a mesh
+// Inputs: OBJ file path, AssImp scene and mesh, component (storage comes from the arena)
+// Output: None
+static void fillComponent(const std::string& objFile, const aiScene* scene, const aiMesh* mesh,
+                          chessComponent& component, meshArena& arena)
+{
+    // Component and texture IDs
+    component.storeComponentID(mesh->mName.C_Str());
+    aiString texturePath;
+    if (scene->mMaterials[mesh->mMaterialIndex]->GetTexture(aiTextureType_DIFFUSE, 0, &texturePath) == AI_SUCCESS)
+    {
+        component.storeTextureID(resolveTexturePath(objFile, texturePath.C_Str()));
+    }
+
+    // Mesh properties
+    meshPropsT meshProps;
+    meshProps.hasBones = mesh->HasBones();
+    meshProps.hasFaces = mesh->HasFaces();
+    meshProps.hasNormals = mesh->HasNormals();
+    meshProps.hasPositions = mesh->HasPositions();
+    meshProps.hasTangentsAndBitangents = mesh->HasTangentsAndBitangents();
+    meshProps.hasTextureCoords = mesh->HasTextureCoords(0);
+    meshProps.hasVertexColors = mesh->HasVertexColors(0);
+    meshProps.numOfUVChannels = mesh->GetNumUVChannels();
+    component.storeMeshProps(meshProps);
+
+    // Vertices, texture coordinates and normals (the arena was sized for them)
+    component.reserveStorage(arena, mesh->mNumVertices, mesh->mNumFaces);
+    for (unsigned int vIdx = 0; vIdx < mesh->mNumVertices; vIdx++)
+    {
+        glm::vec3 vertex(mesh->mVertices[vIdx].x, mesh->mVertices[vIdx].y, mesh->mVertices[vIdx].z);
+        component.addVertices(vertex);
+        if (meshProps.hasTextureCoords)
+        {
+            const aiVector3D& uvw = mesh->mTextureCoords[0][vIdx];
+            glm::vec3 objUVW(uvw.x, uvw.y, uvw.z);
+            component.addTextureCor(objUVW);
+        }
+        if (meshProps.hasNormals)
+        {
+            glm::vec3 normal(mesh->mNormals[vIdx].x, mesh->mNormals[vIdx].y, mesh->mNormals[vIdx].z);
+            component.addVerNormals(normal);
+        }
+    }
+    // Triangles only (points and lines are sorted out)
+    for (unsigned int fIdx = 0; fIdx < mesh->mNumFaces; fIdx++)
+    {
+        if (mesh->mFaces[fIdx].mNumIndices == 3)
+        {
+            component.addFaceIndices(mesh->mFaces[fIdx].mIndices);
+        }
+    }
+}
+
+// Fill a chess component from a cooked mesh
+// Inputs: cooked mesh, component (storage comes from the arena)
+// Output: None
+static void fillComponent(const assetMeshT& mesh, chessComponent& component, meshArena& arena)
+{
+    // Component and texture IDs (the cooker resolved the texture path)
+    component.storeComponentID(mesh.header->name);
+    if (mesh.header->texturePath[0] != '\0')
+    {
+        component.storeTextureID(mesh.header->texturePath);
+    }
+
+    // Mesh properties
+    meshPropsT meshProps = {};
+    meshProps.hasFaces = true;
+    meshProps.hasNormals = (mesh.normals != nullptr);
+    meshProps.hasPositions = true;
+    meshProps.hasTextureCoords = (mesh.uvs != nullptr);
+    meshProps.numOfUVChannels = meshProps.hasTextureCoords ? 1 : 0;
+    component.storeMeshProps(meshProps);
+
+    // The arrays are copied whole (the arena was sized for them)
+    component.reserveStorage(arena, mesh.header->vertexCount, mesh.header->indexCount / 3);
+    component.fillMesh(reinterpret_cast<const glm::vec3*>(mesh.positions), reinterpret_cast<const glm::vec2*>(mesh.uvs),
+                       reinterpret_cast<const glm::vec3*>(mesh.normals), mesh.indices);
+}
+
+// Load the meshes of OBJ files as chess components
+// Inputs: OBJ file paths, chess components (appended to), mesh arena (its block is replaced),
+//         asset bundle (may be closed)
+// Output: true if every file was loaded
+bool loadChessComponents(const std::vector<std::string>& objFiles, std::vector<chessComponent>& components,
+                         meshArena& arena, const assetBundle& bundle)
+{
+    // Cooked meshes point into the bundle, scenes stay loaded until the
+    // components are filled (a file has one or the other)
+    std::vector<std::vector<assetMeshT>> cooked(objFiles.size());
+    std::vector<Assimp::Importer> importers(objFiles.size());
+    std::vector<const aiScene*> scenes(objFiles.size(), nullptr);
+    std::size_t arenaBytes = 0;
+    std::size_t meshCnt = 0;
+    for (std::size_t fIdx = 0; fIdx < objFiles.size(); fIdx++)
+    {
+        if (bundle.isOpen() && bundle.getModelMeshes(objFiles[fIdx], cooked[fIdx]))
+        {
+            for (const assetMeshT& mesh : cooked[fIdx])
+            {
+                if (isComponentMesh(mesh))
+                {
+                    arenaBytes += 2 * meshArena::getFootprint<glm::vec3>(mesh.header->vertexCount) +
+                                  meshArena::getFootprint<glm::vec2>(mesh.header->vertexCount) +
+                                  meshArena::getFootprint<unsigned short>(mesh.header->indexCount);
+                    meshCnt++;
+                }
+            }
+            continue;
+        }
+        scenes[fIdx] = importers[fIdx].ReadFile(objFiles[fIdx],
+                                                aiProcess_Triangulate | aiProcess_JoinIdenticalVertices | aiProcess_SortByPType);
+        if (scenes[fIdx] == nullptr)
+        {
+            std::cout << "Failed to load " << objFiles[fIdx] << ": " << importers[fIdx].GetErrorString() << std::endl;
+            return false;
+        }
+        // Storage of every component mesh
+        for (unsigned int mIdx = 0; mIdx < scenes[fIdx]->mNumMeshes; mIdx++)
+        {
+            const aiMesh* mesh = scenes[fIdx]->mMeshes[mIdx];
+            if (!isComponentMesh(mesh))
+            {
+                std::cout << "Skipping mesh " << mesh->mName.C_Str() << " of " << objFiles[fIdx] << std::endl;
+                continue;
+            }
+            arenaBytes += 2 * meshArena::getFootprint<glm::vec3>(mesh->mNumVertices) +
+                          meshArena::getFootprint<glm::vec2>(mesh->mNumVertices) +
+                          meshArena::getFootprint<unsigned short>(3U * mesh->mNumFaces);
+            meshCnt++;
+        }
+    }
+
+    // One block for all the meshes, components are built in place
+    if (!arena.reserve(arenaBytes))
+    {
+        std::cout << "Out of memory for " << arenaBytes << " bytes of mesh data" << std::endl;
+        return false;
+    }
+    components.reserve(components.size() + meshCnt);
+    for (std::size_t fIdx = 0; fIdx < objFiles.size(); fIdx++)
+    {
+        if (scenes[fIdx] == nullptr)
+        {
+            for (const assetMeshT& mesh : cooked[fIdx])
+            {
+                if (isComponentMesh(mesh))
+                {
+                    components.emplace_back();
+                    fillComponent(mesh, components.back(), arena);
+                }
+            }
+            continue;
+        }
+        for (unsigned int mIdx = 0; mIdx < scenes[fIdx]->mNumMeshes; mIdx++)
+        {
+            const aiMesh* mesh = scenes[fIdx]->mMeshes[mIdx];
+            if (isComponentMesh(mesh))
+            {
+                components.emplace_back();
+                fillComponent(objFiles[fIdx], scenes[fIdx], mesh, components.back(), arena);
+            }
+        }
+    }
+    return true;
+}
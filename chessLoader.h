@@ -0,0 +1,25 @@
+/*
+Objective:
+OBJ loading into chess components (one arena block for all the mesh data, cooked meshes when the asset bundle has them) header file
+*/
+
+#ifndef CHESS_LOADER_H
+#define CHESS_LOADER_H
+
+#include <string>
+#include <vector>
+#include "chessComponent.h"
+#include "mesh_arena.hpp"
+#include "asset_bundle.hpp"
+
+// Load the meshes of OBJ files as chess components. Files cooked into the
+// bundle are copied from it, the others are imported with AssImp. A first
+// pass over all the files sizes the arena block and the component vector,
+// the second fills the components in place (no mesh is copied or moved).
+// Inputs: OBJ file paths, chess components (appended to), mesh arena (its block is replaced),
+//         asset bundle (may be closed)
+// Output: true if every file was loaded
+bool loadChessComponents(const std::vector<std::string>& objFiles, std::vector<chessComponent>& components,
+                         meshArena& arena, const assetBundle& bundle);
+
+#endif
@@ -0,0 +1,282 @@
+/*
+Objective:
+Ray picking (bounding volume hierarchies over instances and mesh triangles) definition file
+*/
+
+#include <algorithm>
+#include <cmath>
+#include "chessPicking.h"
+
+// Build a ray
+// Inputs: origin, direction (not necessarily normalized)
+// Output: ray
+pickRayT makePickRay(const glm::vec3& orig, const glm::vec3& dir)
+{
+    pickRayT ray;
+    ray.orig = orig;
+    ray.dir = dir;
+    ray.invDir = glm::vec3(1.f / dir.x, 1.f / dir.y, 1.f / dir.z);
+    return ray;
+}
+
+// Smallest box holding two boxes
+// Inputs: boxes
+// Output: union box
+static aabbT mergeBoxes(const aabbT& a, const aabbT& b)
+{
+    return {glm::min(a.bMin, b.bMin), glm::max(a.bMax, b.bMax)};
+}
+
+// Nodes of a median split tree (fewer if degenerate sets become leaves early)
+// Inputs: item count, most items kept in a leaf
+// Output: node count
+static std::size_t countTreeNodes(uint32_t count, uint32_t maxLeafSize)
+{
+    if (count <= maxLeafSize)
+    {
+        return 1;
+    }
+    return 1 + countTreeNodes(count / 2, maxLeafSize) + countTreeNodes(count - count / 2, maxLeafSize);
+}
+
+// Build a subtree over items [first, first + count)
+// Inputs: item boxes, centroids, item range
+// Output: None
+void boxBvh::buildNode(const std::vector<aabbT>& boxes, const std::vector<glm::vec3>& centroids,
+                       uint32_t first, uint32_t count)
+{
+    uint32_t nIdx = static_cast<uint32_t>(nodes.size());
+    nodes.push_back(bvhNodeT());
+
+    aabbT bounds = boxes[items[first]];
+    glm::vec3 cMin = centroids[items[first]];
+    glm::vec3 cMax = cMin;
+    for (uint32_t i = first + 1; i < first + count; i++)
+    {
+        bounds = mergeBoxes(bounds, boxes[items[i]]);
+        cMin = glm::min(cMin, centroids[items[i]]);
+        cMax = glm::max(cMax, centroids[items[i]]);
+    }
+    nodes[nIdx].bounds = bounds;
+
+    // Small or degenerate sets become leaves
+    glm::vec3 spread = cMax - cMin;
+    if (count <= leafSize || (spread.x <= 0.f && spread.y <= 0.f && spread.z <= 0.f))
+    {
+        nodes[nIdx].rightOrFirst = first;
+        nodes[nIdx].count = count;
+        return;
+    }
+
+    // Split at the median of the widest centroid axis
+    int axis = (spread.x >= spread.y && spread.x >= spread.z) ? 0 : ((spread.y >= spread.z) ? 1 : 2);
+    uint32_t half = count / 2;
+    std::nth_element(items.begin() + first, items.begin() + first + half, items.begin() + first + count,
+                     [&centroids, axis](uint32_t a, uint32_t b) { return centroids[a][axis] < centroids[b][axis]; });
+
+    // Left child is the next node, the right one comes after the left subtree
+    buildNode(boxes, centroids, first, half);
+    nodes[nIdx].rightOrFirst = static_cast<uint32_t>(nodes.size());
+    nodes[nIdx].count = 0;
+    buildNode(boxes, centroids, first + half, count - half);
+}
+
+// Build the hierarchy
+// Inputs: item boxes, most items kept in a leaf
+// Output: None
+void boxBvh::build(const std::vector<aabbT>& boxes, uint32_t maxLeafSize)
+{
+    leafSize = std::max(maxLeafSize, 1U);
+    nodes.clear();
+    items.resize(boxes.size());
+    if (boxes.empty())
+    {
+        return;
+    }
+
+    std::vector<glm::vec3> centroids(boxes.size());
+    for (uint32_t i = 0; i < boxes.size(); i++)
+    {
+        items[i] = i;
+        centroids[i] = 0.5f * (boxes[i].bMin + boxes[i].bMax);
+    }
+    nodes.reserve(countTreeNodes(static_cast<uint32_t>(boxes.size()), leafSize));
+    buildNode(boxes, centroids, 0, static_cast<uint32_t>(boxes.size()));
+}
+
+// Recompute the node bounds after the boxes moved (topology is kept)
+// Inputs: item boxes (same count and order as the build)
+// Output: None
+void boxBvh::refit(const std::vector<aabbT>& boxes)
+{
+    // Children are stored after their parent, so walk back to the root
+    for (std::size_t nIdx = nodes.size(); nIdx-- > 0;)
+    {
+        bvhNodeT& node = nodes[nIdx];
+        if (node.count > 0)
+        {
+            node.bounds = boxes[items[node.rightOrFirst]];
+            for (uint32_t i = 1; i < node.count; i++)
+            {
+                node.bounds = mergeBoxes(node.bounds, boxes[items[node.rightOrFirst + i]]);
+            }
+        }
+        else
+        {
+            node.bounds = mergeBoxes(nodes[nIdx + 1].bounds, nodes[node.rightOrFirst].bounds);
+        }
+    }
+}
+
+// Bounds of everything
+// Inputs: None
+// Output: root box
+aabbT boxBvh::getBounds() const
+{
+    if (nodes.empty())
+    {
+        return {glm::vec3(0.f), glm::vec3(0.f)};
+    }
+    return nodes[0].bounds;
+}
+
+// Is the hierarchy empty
+// Inputs: None
+// Output: true if nothing was built
+bool boxBvh::isEmpty() const
+{
+    return nodes.empty();
+}
+
+// Can a ray hit a triangle (valid indices, non zero area)
+// Inputs: vertices, indices, first index of the triangle
+// Output: true if the triangle can be hit
+static bool isHittable(meshSpan<const glm::vec3> meshVertices, meshSpan<const unsigned short> meshIndices, std::size_t first)
+{
+    for (std::size_t i = first; i < first + 3; i++)
+    {
+        if (meshIndices[i] >= meshVertices.size())
+        {
+            return false;
+        }
+    }
+    const glm::vec3& v0 = meshVertices[meshIndices[first]];
+    glm::vec3 normal = glm::cross(meshVertices[meshIndices[first + 1]] - v0, meshVertices[meshIndices[first + 2]] - v0);
+    return normal != glm::vec3(0.f);
+}
+
+// Build from an indexed triangle list
+// Inputs: vertices, indices
+// Output: None
+void meshBvh::build(meshSpan<const glm::vec3> meshVertices, meshSpan<const unsigned short> meshIndices)
+{
+    // Own compact copy, the mesh data is released once it is on the GPU:
+    // positions only, each stored once (the vertices split at UV and normal
+    // seams share one), and only the triangles a ray can hit
+    std::vector<unsigned short> order;
+    order.reserve(meshVertices.size());
+    for (std::size_t vIdx = 0; vIdx < meshVertices.size(); vIdx++)
+    {
+        order.push_back(static_cast<unsigned short>(vIdx));
+    }
+    std::sort(order.begin(), order.end(), [&meshVertices](unsigned short a, unsigned short b)
+    {
+        const glm::vec3& va = meshVertices[a];
+        const glm::vec3& vb = meshVertices[b];
+        return (va.x != vb.x) ? va.x < vb.x : ((va.y != vb.y) ? va.y < vb.y : va.z < vb.z);
+    });
+    std::vector<unsigned short> welded(meshVertices.size());
+    std::size_t positionCnt = 0;
+    for (std::size_t i = 0; i < order.size(); i++)
+    {
+        if (i > 0 && meshVertices[order[i]] != meshVertices[order[i - 1]])
+        {
+            positionCnt++;
+        }
+        welded[order[i]] = static_cast<unsigned short>(positionCnt);
+    }
+    vertices.resize(order.empty() ? 0 : positionCnt + 1);
+    vertices.shrink_to_fit();
+    for (std::size_t vIdx = 0; vIdx < meshVertices.size(); vIdx++)
+    {
+        vertices[welded[vIdx]] = meshVertices[vIdx];
+    }
+
+    // Degenerate triangles (no area, the hit test rejects them) are dropped
+    std::size_t triangleCnt = 0;
+    for (std::size_t i = 0; i + 2 < meshIndices.size(); i += 3)
+    {
+        triangleCnt += isHittable(meshVertices, meshIndices, i) ? 1 : 0;
+    }
+    triangles.clear();
+    triangles.shrink_to_fit();
+    triangles.reserve(3 * triangleCnt);
+    for (std::size_t i = 0; i + 2 < meshIndices.size(); i += 3)
+    {
+        if (isHittable(meshVertices, meshIndices, i))
+        {
+            triangles.insert(triangles.end(), {welded[meshIndices[i]], welded[meshIndices[i + 1]], welded[meshIndices[i + 2]]});
+        }
+    }
+
+    std::vector<aabbT> boxes(triangles.size() / 3);
+    for (std::size_t tIdx = 0; tIdx < boxes.size(); tIdx++)
+    {
+        const glm::vec3& v0 = vertices[triangles[3 * tIdx]];
+        const glm::vec3& v1 = vertices[triangles[3 * tIdx + 1]];
+        const glm::vec3& v2 = vertices[triangles[3 * tIdx + 2]];
+        boxes[tIdx] = {glm::min(v0, glm::min(v1, v2)), glm::max(v0, glm::max(v1, v2))};
+    }
+    bvh.build(boxes, MESH_BVH_LEAF_SIZE);
+}
+
+// Closest hit along a ray
+// Inputs: model space ray, search distance
+// Output: true if a triangle is hit before tMax, t is the hit distance
+bool meshBvh::intersect(const pickRayT& ray, float tMax, float& t) const
+{
+    bool hit = false;
+    bvh.traverse(ray, tMax, [&](uint32_t tIdx, float tBest)
+    {
+        // Moller-Trumbore, both faces (picking ignores culling)
+        const glm::vec3& v0 = vertices[triangles[3 * tIdx]];
+        glm::vec3 e1 = vertices[triangles[3 * tIdx + 1]] - v0;
+        glm::vec3 e2 = vertices[triangles[3 * tIdx + 2]] - v0;
+        glm::vec3 p = glm::cross(ray.dir, e2);
+        float det = glm::dot(e1, p);
+        if (std::fabs(det) < 1e-12f)
+        {
+            return tBest;
+        }
+        float invDet = 1.f / det;
+        glm::vec3 s = ray.orig - v0;
+        float u = glm::dot(s, p) * invDet;
+        if (u < 0.f || u > 1.f)
+        {
+            return tBest;
+        }
+        glm::vec3 q = glm::cross(s, e1);
+        float v = glm::dot(ray.dir, q) * invDet;
+        if (v < 0.f || u + v > 1.f)
+        {
+            return tBest;
+        }
+        float tHit = glm::dot(e2, q) * invDet;
+        if (tHit < 0.f || tHit >= tBest)
+        {
+            return tBest;
+        }
+        hit = true;
+        t = tHit;
+        return tHit;
+    });
+    return hit;
+}
+
+// Bounds of the mesh
+// Inputs: None
+// Output: model space box
+aabbT meshBvh::getBounds() const
+{
+    return bvh.getBounds();
+}
@@ -0,0 +1,192 @@
+/*
+Objective:
+Ray picking (bounding volume hierarchies over instances and mesh triangles) header file
+*/
+
+#ifndef CHESS_PICKING_H
+#define CHESS_PICKING_H
+
+#include <cstdint>
+#include <vector>
+
+// Include GLM
+#include <glm/glm.hpp>
+// Mesh array views
+#include "mesh_arena.hpp"
+
+// Most primitives kept in a leaf
+const unsigned int BVH_LEAF_SIZE = 4;
+// Triangle hierarchies are built once and only walked on a click: larger
+// leaves halve their nodes, which outweigh the triangles they hold
+const unsigned int MESH_BVH_LEAF_SIZE = 8;
+
+// Axis aligned bounding box
+typedef struct
+{
+    glm::vec3 bMin;
+    glm::vec3 bMax;
+} aabbT;
+
+// BVH node, stored depth first: the left child follows its parent
+typedef struct
+{
+    aabbT bounds;
+    uint32_t rightOrFirst;     // Right child (inner node) or first item (leaf)
+    uint32_t count;            // Items in the leaf, 0 for an inner node
+} bvhNodeT;
+
+// Ray with the reciprocal direction precomputed for the slab tests
+typedef struct
+{
+    glm::vec3 orig;
+    glm::vec3 dir;
+    glm::vec3 invDir;
+} pickRayT;
+
+// Build a ray
+// Inputs: origin, direction (not necessarily normalized)
+// Output: ray
+pickRayT makePickRay(const glm::vec3& orig, const glm::vec3& dir);
+
+// Hierarchy over a set of boxes (median split on the widest centroid axis)
+class boxBvh
+{
+private:
+    std::vector<bvhNodeT> nodes;
+    std::vector<uint32_t> items;   // Box indices, leaves own contiguous ranges
+    uint32_t leafSize = BVH_LEAF_SIZE;
+
+    // Build a subtree over items [first, first + count)
+    // Inputs: item boxes, centroids, item range
+    // Output: None
+    void buildNode(const std::vector<aabbT>& boxes, const std::vector<glm::vec3>& centroids,
+                   uint32_t first, uint32_t count);
+
+public:
+    // Build the hierarchy
+    // Inputs: item boxes, most items kept in a leaf
+    // Output: None
+    void build(const std::vector<aabbT>& boxes, uint32_t maxLeafSize = BVH_LEAF_SIZE);
+    // Recompute the node bounds after the boxes moved (topology is kept)
+    // Inputs: item boxes (same count and order as the build)
+    // Output: None
+    void refit(const std::vector<aabbT>& boxes);
+    // Visit the items whose box the ray enters before tMax, near boxes first.
+    // The visitor returns the hit distance (or tMax) and may shorten the search.
+    // Inputs: ray, search distance, visitor (item index, current tMax) -> new tMax
+    // Output: None
+    template <typename visitT>
+    void traverse(const pickRayT& ray, float tMax, visitT visit) const;
+    // Bounds of everything
+    // Inputs: None
+    // Output: root box
+    aabbT getBounds() const;
+    // Is the hierarchy empty
+    // Inputs: None
+    // Output: true if nothing was built
+    bool isEmpty() const;
+};
+
+// Triangle hierarchy of a mesh (model space)
+class meshBvh
+{
+private:
+    boxBvh bvh;
+    std::vector<glm::vec3> vertices;          // Distinct positions
+    std::vector<unsigned short> triangles;    // Three position indices per triangle
+
+public:
+    // Build from an indexed triangle list
+    // Inputs: vertices, indices
+    // Output: None
+    void build(meshSpan<const glm::vec3> meshVertices, meshSpan<const unsigned short> meshIndices);
+    // Closest hit along a ray
+    // Inputs: model space ray, search distance
+    // Output: true if a triangle is hit before tMax, t is the hit distance
+    bool intersect(const pickRayT& ray, float tMax, float& t) const;
+    // Bounds of the mesh
+    // Inputs: None
+    // Output: model space box
+    aabbT getBounds() const;
+};
+
+// Ray/box slab test
+// Inputs: ray, box, search distance
+// Output: true if the box is entered before tMax, tEnter is the entry distance
+inline bool intersectBox(const pickRayT& ray, const aabbT& box, float tMax, float& tEnter)
+{
+    glm::vec3 t0 = (box.bMin - ray.orig) * ray.invDir;
+    glm::vec3 t1 = (box.bMax - ray.orig) * ray.invDir;
+    glm::vec3 tNear = glm::min(t0, t1);
+    glm::vec3 tFar = glm::max(t0, t1);
+    float tIn = glm::max(glm::max(tNear.x, tNear.y), glm::max(tNear.z, 0.f));
+    float tOut = glm::min(glm::min(tFar.x, tFar.y), glm::min(tFar.z, tMax));
+    tEnter = tIn;
+    return tIn <= tOut;
+}
+
+// Visit the items whose box the ray enters before tMax, near boxes first.
+// The visitor returns the hit distance (or tMax) and may shorten the search.
+// Inputs: ray, search distance, visitor (item index, current tMax) -> new tMax
+// Output: None
+template <typename visitT>
+void boxBvh::traverse(const pickRayT& ray, float tMax, visitT visit) const
+{
+    float tEnter;
+    if (nodes.empty() || !intersectBox(ray, nodes[0].bounds, tMax, tEnter))
+    {
+        return;
+    }
+
+    // Median splits keep the depth near log2 of the item count
+    struct
+    {
+        uint32_t node;
+        float tEnter;
+    } stack[64];
+    unsigned int top = 0;
+    stack[top++] = {0, tEnter};
+    while (top > 0)
+    {
+        top--;
+        // Skip boxes behind a hit found since they were pushed
+        if (stack[top].tEnter > tMax)
+        {
+            continue;
+        }
+        const bvhNodeT& node = nodes[stack[top].node];
+        if (node.count > 0)
+        {
+            for (uint32_t i = 0; i < node.count; i++)
+            {
+                tMax = visit(items[node.rightOrFirst + i], tMax);
+            }
+            continue;
+        }
+
+        // Push the far child first so the near one is searched first
+        uint32_t left = static_cast<uint32_t>(&node - nodes.data()) + 1;
+        uint32_t right = node.rightOrFirst;
+        float tLeft, tRight;
+        bool hitLeft = intersectBox(ray, nodes[left].bounds, tMax, tLeft);
+        bool hitRight = intersectBox(ray, nodes[right].bounds, tMax, tRight);
+        if (hitLeft && hitRight && tLeft > tRight)
+        {
+            stack[top++] = {left, tLeft};
+            stack[top++] = {right, tRight};
+        }
+        else
+        {
+            if (hitRight)
+            {
+                stack[top++] = {right, tRight};
+            }
+            if (hitLeft)
+            {
+                stack[top++] = {left, tLeft};
+            }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,541 @@
+/*
+Objective:
+Chess scene (many boards sharing one copy of the assets) definition file
+*/
+
+#include <cmath>
+#include "chessScene.h"
+
+// World box of a transformed model box (centre and extent, no corner loop)
+// Inputs: model matrix, model space box
+// Output: world space box
+static aabbT transformBox(const glm::mat4& model, const aabbT& box)
+{
+    glm::vec3 centre = 0.5f * (box.bMin + box.bMax);
+    glm::vec3 extent = 0.5f * (box.bMax - box.bMin);
+    glm::vec3 wCentre = glm::vec3(model * glm::vec4(centre, 1.f));
+    glm::vec3 wExtent(0.f);
+    for (int col = 0; col < 3; col++)
+    {
+        for (int row = 0; row < 3; row++)
+        {
+            wExtent[row] += std::fabs(model[col][row]) * extent[col];
+        }
+    }
+    return {wCentre - wExtent, wCentre + wExtent};
+}
+
+// Group the instances by component
+// Inputs: number of components
+// Output: None
+void chessScene::rebuildBatches(unsigned int componentCnt)
+{
+    // Count the instances of every component (and those of the moving set)
+    std::vector<unsigned int> counts(componentCnt, 0);
+    std::vector<unsigned int> movingCounts(componentCnt, 0);
+    for (unsigned int b = 0; b < boards.size(); b++)
+    {
+        for (unsigned int pIdx = 0; pIdx < piecesPerBoard; pIdx++)
+        {
+            unsigned int cIdx = boards[b].getPiece(pIdx).compIdx;
+            counts[cIdx]++;
+            movingCounts[cIdx] += inMovingSet[b * piecesPerBoard + pIdx];
+        }
+    }
+
+    // One batch per used component, slots are handed out in batch order with
+    // the moving set at the end of each batch
+    batches.clear();
+    std::vector<unsigned int> nextSlot(componentCnt, 0);
+    std::vector<unsigned int> nextMovingSlot(componentCnt, 0);
+    unsigned int first = 0;
+    for (unsigned int cIdx = 0; cIdx < componentCnt; cIdx++)
+    {
+        if (counts[cIdx] == 0)
+        {
+            continue;
+        }
+        batches.push_back({cIdx, first, counts[cIdx], movingCounts[cIdx]});
+        nextSlot[cIdx] = first;
+        nextMovingSlot[cIdx] = first + counts[cIdx] - movingCounts[cIdx];
+        first += counts[cIdx];
+    }
+    for (unsigned int b = 0; b < boards.size(); b++)
+    {
+        for (unsigned int pIdx = 0; pIdx < piecesPerBoard; pIdx++)
+        {
+            unsigned int gIdx = b * piecesPerBoard + pIdx;
+            unsigned int cIdx = boards[b].getPiece(pIdx).compIdx;
+            instanceSlots[gIdx] = inMovingSet[gIdx] ? nextMovingSlot[cIdx]++ : nextSlot[cIdx]++;
+        }
+    }
+
+    batchesDirty = false;
+    // Every instance may have changed slot
+    matricesDirty = true;
+    staticVersion++;
+}
+
+// Starts the animations for an applied move
+// Inputs: board index, move result, delay in ticks
+// Output: None
+void chessScene::animateMove(unsigned int board, const moveResultT& result, unsigned int delay)
+{
+    const chessBoard& cBoard = boards[board];
+    unsigned int base = board * piecesPerBoard;
+
+    // Captured piece leaves as the mover lands
+    if (result.capturedPiece >= 0)
+    {
+        animator.startTrack(base + result.capturedPiece, cBoard.getPiece(result.capturedPiece).cTPosition.tPos,
+                            CAPTURE_TICKS, delay + MOVE_TICKS * 2 / 3, MOVE_ARC);
+    }
+    // Castling rook slides along with the king
+    if (result.rookPiece >= 0)
+    {
+        animator.startTrack(base + result.rookPiece, cBoard.getPiece(result.rookPiece).cTPosition.tPos,
+                            MOVE_TICKS, delay);
+    }
+    animator.startTrack(base + result.movedPiece, cBoard.getPiece(result.movedPiece).cTPosition.tPos,
+                        MOVE_TICKS, delay, MOVE_ARC);
+    // Promotion swaps the mesh
+    if (result.promoted)
+    {
+        batchesDirty = true;
+    }
+}
+
+// Constructor function
+chessScene::chessScene()
+{
+    piecesPerBoard = 0;
+    gridSize = 1;
+    cameraTrack = 0;
+    instanceBuffer = 0;
+    batchesDirty = true;
+    matricesDirty = true;
+    pickTreeDirty = true;
+    pickBoundsDirty = true;
+    drawnAnimating = false;
+    staticVersion = 0;
+}
+
+// Destructor function
+chessScene::~chessScene()
+{
+    release();
+}
+
+// Delete the GL objects (call while the GL context is alive)
+// Inputs: None
+// Output: None
+void chessScene::release()
+{
+    // Delete the instance buffer
+    if (instanceBuffer != 0)
+    {
+        glDeleteBuffers(1, &instanceBuffer);
+        instanceBuffer = 0;
+    }
+}
+
+// Build the boards and their tracks (camera is reset to frame the grid)
+// Inputs: Chess components, target Model matrix specs, number of boards
+// Output: None
+void chessScene::setupBoards(std::vector<chessComponent>& components, tModelMap& cTModelMap, unsigned int boardCnt)
+{
+    boardCnt = (boardCnt > 0) ? boardCnt : 1;
+    gridSize = static_cast<unsigned int>(std::ceil(std::sqrt(static_cast<float>(boardCnt))));
+
+    // All the boards start from the same position
+    boards.assign(1, chessBoard());
+    boards[0].setupPieces(components, cTModelMap);
+    boards.resize(boardCnt, boards[0]);
+    piecesPerBoard = boards[0].getPieceCount();
+
+    // Square grid centred on the origin
+    boardOffsets.resize(boardCnt);
+    float half = 0.5f * (gridSize - 1);
+    for (unsigned int b = 0; b < boardCnt; b++)
+    {
+        boardOffsets[b] = glm::vec3(((b % gridSize) - half) * BOARD_PITCH,
+                                    ((b / gridSize) - half) * BOARD_PITCH, 0.f);
+    }
+
+    // Tracks hold board local positions
+    unsigned int instanceCnt = boardCnt * piecesPerBoard;
+    cameraTrack = instanceCnt;
+    animator.reserveTracks(instanceCnt + 1);
+    for (unsigned int b = 0; b < boardCnt; b++)
+    {
+        for (unsigned int pIdx = 0; pIdx < piecesPerBoard; pIdx++)
+        {
+            animator.resetTrack(b * piecesPerBoard + pIdx, boards[b].getPiece(pIdx).cTPosition.tPos);
+        }
+    }
+    // Camera starts at (10, 10, 10) looking at the origin, pulled back to fit the grid
+    animator.resetTrack(cameraTrack, glm::vec3(54.7356f, 45.f, CAMERA_FIT_DISTANCE * gridSize));
+
+    // Instance storage (sized once per layout, never per frame)
+    instanceMatrices.assign(instanceCnt, glm::mat4(1.0f));
+    instanceSlots.assign(instanceCnt, 0);
+    instanceBoxes.resize(instanceCnt);
+    wasMoving.assign(instanceCnt, 0);
+    inMovingSet.assign(instanceCnt, 0);
+    if (instanceBuffer == 0)
+    {
+        glGenBuffers(1, &instanceBuffer);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, instanceCnt * sizeof(glm::mat4), NULL, GL_DYNAMIC_DRAW);
+    batchesDirty = true;
+    matricesDirty = true;
+    pickTreeDirty = true;
+
+    // Triangle hierarchies, once per component (never rebuilt on a click)
+    if (meshBvhs.size() != components.size())
+    {
+        meshBvhs.resize(components.size());
+        for (unsigned int cIdx = 0; cIdx < components.size(); cIdx++)
+        {
+            meshBvhs[cIdx].build(components[cIdx].getVertices(), components[cIdx].getIndices());
+        }
+    }
+}
+
+// Applies a move to a board and animates it
+// Inputs: board index, move string, delay in ticks
+// Output: true if the move was applied
+bool chessScene::playMove(unsigned int board, std::string_view move, unsigned int delay)
+{
+    moveResultT result;
+    if (board >= boards.size() || !boards[board].applyMove(move, result))
+    {
+        return false;
+    }
+    animateMove(board, result, delay);
+    return true;
+}
+
+// Replaces a board's position, the pieces glide to their new places
+// Inputs: board index, position (set up from the same components)
+// Output: true if the position was replaced
+bool chessScene::setBoard(unsigned int board, const chessBoard& position)
+{
+    if (board >= boards.size() || position.getPieceCount() != piecesPerBoard)
+    {
+        return false;
+    }
+    boards[board] = position;
+    unsigned int base = board * piecesPerBoard;
+    for (unsigned int pIdx = 0; pIdx < piecesPerBoard; pIdx++)
+    {
+        animator.startTrack(base + pIdx, position.getPiece(pIdx).cTPosition.tPos, SEEK_TICKS);
+    }
+    // Promotions may differ
+    batchesDirty = true;
+    return true;
+}
+
+// Get a board's position
+// Inputs: board index
+// Output: board
+const chessBoard& chessScene::getBoard(unsigned int board) const
+{
+    return boards[board];
+}
+
+// Moves the camera (takes the short way around)
+// Inputs: camera spherical coordinates (theta, phi, r)
+// Output: None
+void chessScene::moveCamera(glm::vec3 camera)
+{
+    float fromPhi = animator.getTarget(cameraTrack).y;
+    while (camera.y - fromPhi > 180.f) camera.y -= 360.f;
+    while (camera.y - fromPhi < -180.f) camera.y += 360.f;
+    animator.startTrack(cameraTrack, camera, CAMERA_TICKS);
+}
+
+// Interpolated camera
+// Inputs: blend factor
+// Output: camera spherical coordinates (theta, phi, r)
+glm::vec3 chessScene::getCamera(float alpha) const
+{
+    return animator.getValue(cameraTrack, alpha);
+}
+
+// Runs the simulation ticks covered by the elapsed time
+// Inputs: elapsed time (seconds)
+// Output: number of ticks run
+unsigned int chessScene::advance(double frameTime)
+{
+    return animator.advance(frameTime);
+}
+
+// Blend factor between the last two ticks
+// Inputs: None
+// Output: blend factor
+float chessScene::getAlpha() const
+{
+    return animator.getAlpha();
+}
+
+// Draw all the boards (one instanced draw per component)
+// Inputs: Chess components, texture sampler uniform, blend factor
+// Output: None
+void chessScene::renderBoards(std::vector<chessComponent>& components, GLuint TextureID, float alpha)
+{
+    updateInstances(components, alpha);
+    drawInstances(components, TextureID, SCENE_DRAW_ALL);
+}
+
+// Bring the instance matrices up to date for a frame
+// Inputs: Chess components, blend factor
+// Output: None
+void chessScene::updateInstances(std::vector<chessComponent>& components, float alpha)
+{
+    drawnAnimating = animator.isAnimating();
+    if (batchesDirty)
+    {
+        rebuildBatches(static_cast<unsigned int>(components.size()));
+    }
+
+    // Only moving instances need a new model matrix
+    unsigned int loSlot = static_cast<unsigned int>(instanceMatrices.size());
+    unsigned int hiSlot = 0;
+    for (unsigned int b = 0; b < boards.size(); b++)
+    {
+        for (unsigned int pIdx = 0; pIdx < piecesPerBoard; pIdx++)
+        {
+            unsigned int gIdx = b * piecesPerBoard + pIdx;
+            bool moving = animator.isTrackMoving(gIdx);
+            // One more update once settled, to land exactly on the target
+            if (!moving && !wasMoving[gIdx] && !matricesDirty)
+            {
+                continue;
+            }
+            wasMoving[gIdx] = moving;
+
+            const pieceInstanceT& piece = boards[b].getPiece(pIdx);
+            tPosition cTPositionMorph = piece.cTPosition;
+            cTPositionMorph.tPos = animator.getValue(gIdx, alpha) + boardOffsets[b];
+            unsigned int slot = instanceSlots[gIdx];
+            instanceMatrices[slot] = components[piece.compIdx].genModelMatrix(cTPositionMorph);
+            loSlot = (slot < loSlot) ? slot : loSlot;
+            hiSlot = (slot > hiSlot) ? slot : hiSlot;
+        }
+    }
+    matricesDirty = false;
+
+    // Upload the changed range only
+    if (loSlot <= hiSlot)
+    {
+        pickBoundsDirty = true;
+        glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+        glBufferSubData(GL_ARRAY_BUFFER, loSlot * sizeof(glm::mat4),
+                        (hiSlot - loSlot + 1) * sizeof(glm::mat4), &instanceMatrices[loSlot]);
+    }
+
+    // New boards: build the picking hierarchy now rather than on a click
+    if (pickTreeDirty)
+    {
+        updateInstanceBoxes();
+        instanceBvh.build(instanceBoxes);
+        pickTreeDirty = false;
+        pickBoundsDirty = false;
+    }
+}
+
+// Draw a part of the boards with the current instance matrices
+// Inputs: Chess components, texture sampler uniform, part (SCENE_DRAW_*)
+// Output: None
+void chessScene::drawInstances(std::vector<chessComponent>& components, GLuint TextureID, unsigned int part)
+{
+    for (const auto& batch : batches)
+    {
+        unsigned int first = batch.first;
+        unsigned int count = batch.count;
+        if (part == SCENE_DRAW_STATIC)
+        {
+            count -= batch.movingCount;
+        }
+        else if (part == SCENE_DRAW_MOVING)
+        {
+            first += batch.count - batch.movingCount;
+            count = batch.movingCount;
+        }
+        if (count == 0)
+        {
+            continue;
+        }
+        // Bind our texture (set it up)
+        components[batch.compIdx].setupTexture(TextureID);
+        // Render all the copies at once
+        components[batch.compIdx].renderMesh(instanceBuffer, first, count);
+    }
+}
+
+// Grow the moving set by the instances that started moving (the set starts
+// over with each animation, the static part is everything else)
+// Inputs: None
+// Output: true if the set changed
+bool chessScene::updateMovingSet()
+{
+    // Landed pieces stay in the set until everything has landed, a new
+    // animation after a settled frame starts from an empty set
+    unsigned char keep = drawnAnimating ? 1 : 0;
+    bool changed = false;
+    for (unsigned int gIdx = 0; gIdx < inMovingSet.size(); gIdx++)
+    {
+        unsigned char moving = (inMovingSet[gIdx] & keep) | (animator.isTrackMoving(gIdx) ? 1 : 0);
+        changed = changed || (moving != inMovingSet[gIdx]);
+        inMovingSet[gIdx] = moving;
+    }
+    if (changed)
+    { // Slots are regrouped around the new set
+        batchesDirty = true;
+    }
+    return changed;
+}
+
+// Version of the static part (changes when it has to be drawn again)
+// Inputs: None
+// Output: version
+unsigned int chessScene::getStaticVersion() const
+{
+    return staticVersion;
+}
+
+// Check whether the last drawn frame is out of date
+// Inputs: None
+// Output: true if boards, pieces or the camera changed since
+bool chessScene::needsRedraw() const
+{
+    // New transitions count as animating from the moment they are started
+    return batchesDirty || matricesDirty || drawnAnimating || animator.isAnimating();
+}
+
+// Check for a running animation
+// Inputs: None
+// Output: true while anything moves
+bool chessScene::isAnimating() const
+{
+    return animator.isAnimating();
+}
+
+// Check for a camera transition
+// Inputs: None
+// Output: true while the camera moves
+bool chessScene::isCameraMoving() const
+{
+    return animator.isTrackMoving(cameraTrack);
+}
+
+// World boxes of all the instances from the drawn matrices
+// Inputs: None
+// Output: None
+void chessScene::updateInstanceBoxes()
+{
+    for (unsigned int b = 0; b < boards.size(); b++)
+    {
+        for (unsigned int pIdx = 0; pIdx < piecesPerBoard; pIdx++)
+        {
+            unsigned int gIdx = b * piecesPerBoard + pIdx;
+            const aabbT& meshBox = meshBvhs[boards[b].getPiece(pIdx).compIdx].getBounds();
+            instanceBoxes[gIdx] = transformBox(instanceMatrices[instanceSlots[gIdx]], meshBox);
+        }
+    }
+}
+
+// Closest instance along a ray (as drawn by the last renderBoards)
+// Inputs: world space ray origin and direction, result
+// Output: true if something was hit
+bool chessScene::pick(const glm::vec3& orig, const glm::vec3& dir, pickResultT& result)
+{
+    result.board = -1;
+    result.piece = -1;
+    result.file = -1;
+    result.rank = -1;
+    // Matrices are only valid once drawn
+    if (instanceMatrices.empty() || batchesDirty || matricesDirty || pickTreeDirty)
+    {
+        return false;
+    }
+
+    // Pieces moved since: same tree, new bounds (one pass over the instances)
+    if (pickBoundsDirty)
+    {
+        updateInstanceBoxes();
+        instanceBvh.refit(instanceBoxes);
+        pickBoundsDirty = false;
+    }
+
+    // Boxes near to far, exact triangle test in model space (t is shared
+    // since the ray is mapped affinely)
+    pickRayT ray = makePickRay(orig, dir);
+    int hitIdx = -1;
+    float hitT = 0.f;
+    instanceBvh.traverse(ray, INFINITY, [&](uint32_t gIdx, float tMax)
+    {
+        unsigned int compIdx = boards[gIdx / piecesPerBoard].getPiece(gIdx % piecesPerBoard).compIdx;
+        glm::mat4 invModel = glm::inverse(instanceMatrices[instanceSlots[gIdx]]);
+        pickRayT modelRay = makePickRay(glm::vec3(invModel * glm::vec4(orig, 1.f)),
+                                        glm::vec3(invModel * glm::vec4(dir, 0.f)));
+        float t;
+        if (!meshBvhs[compIdx].intersect(modelRay, tMax, t))
+        {
+            return tMax;
+        }
+        hitIdx = static_cast<int>(gIdx);
+        hitT = t;
+        return t;
+    });
+    if (hitIdx < 0)
+    {
+        return false;
+    }
+
+    unsigned int gIdx = static_cast<unsigned int>(hitIdx);
+    unsigned int board = gIdx / piecesPerBoard;
+    const pieceInstanceT& piece = boards[board].getPiece(gIdx % piecesPerBoard);
+    result.board = static_cast<int>(board);
+    result.point = orig + hitT * dir;
+    if (piece.file >= 0)
+    { // A piece on its square
+        result.piece = static_cast<int>(gIdx % piecesPerBoard);
+        result.file = piece.file;
+        result.rank = piece.rank;
+    }
+    else if (piece.captured)
+    { // A captured piece, next to the board
+        result.piece = static_cast<int>(gIdx % piecesPerBoard);
+    }
+    else
+    { // The board itself, find the square under the hit
+        glm::vec3 local = result.point - boardOffsets[board];
+        int file = static_cast<int>(std::floor(local.x / CHESS_BOX_SIZE + 4.f));
+        int rank = static_cast<int>(std::floor(local.y / CHESS_BOX_SIZE + 4.f));
+        if (file >= 0 && file < 8 && rank >= 0 && rank < 8)
+        {
+            result.file = file;
+            result.rank = rank;
+        }
+    }
+    return true;
+}
+
+// Get the number of boards
+// Inputs: None
+// Output: board count
+unsigned int chessScene::getBoardCount() const
+{
+    return static_cast<unsigned int>(boards.size());
+}
+
+// Get the number of boards per grid side
+// Inputs: None
+// Output: grid size
+unsigned int chessScene::getGridSize() const
+{
+    return gridSize;
+}
@@ -0,0 +1,191 @@
+/*
+Objective:
+Chess scene (many boards sharing one copy of the assets) header file
+*/
+
+#ifndef CHESS_SCENE_H
+#define CHESS_SCENE_H
+
+#include <string_view>
+#include <vector>
+#include "chessCommon.h"
+#include "chessComponent.h"
+#include "chessBoard.h"
+#include "chessAnimation.h"
+#include "chessPicking.h"
+
+// Include GLM
+#include <glm/glm.hpp>
+// Include GLEW
+#include <GL/glew.h>
+
+// Distance between neighbouring boards of the grid
+const float BOARD_PITCH = 11.f * CHESS_BOX_SIZE;
+// Camera distance that frames a single board
+const float CAMERA_FIT_DISTANCE = 17.3205f;
+// Glide to a restored position (ticks)
+const unsigned int SEEK_TICKS = 12;
+
+// Parts of the scene a draw covers (see updateMovingSet)
+const unsigned int SCENE_DRAW_ALL = 0;
+const unsigned int SCENE_DRAW_STATIC = 1;
+const unsigned int SCENE_DRAW_MOVING = 2;
+
+// One instanced draw (all the instances of a component)
+typedef struct
+{
+    unsigned int compIdx;      // Component (mesh + texture) to draw
+    unsigned int first;        // First instance slot
+    unsigned int count;        // Number of instances
+    unsigned int movingCount;  // Instances of the moving set (the last ones)
+} drawBatchT;
+
+// What lies under a picking ray
+typedef struct
+{
+    int board;                 // Board index (-1 if nothing was hit)
+    int piece;                 // Piece instance on the board (-1 for the board itself)
+    int file;                  // Square under the hit (-1 if off the squares)
+    int rank;
+    glm::vec3 point;           // World space hit
+} pickResultT;
+
+class chessScene
+{
+private:
+    // Game states, laid out on a square grid in world space
+    std::vector<chessBoard> boards;
+    std::vector<glm::vec3> boardOffsets;
+    unsigned int piecesPerBoard;
+    unsigned int gridSize;
+
+    // Animation tracks: board b instance i is track b * piecesPerBoard + i,
+    // the camera (theta, phi, r) is the last track
+    chessAnimator animator;
+    unsigned int cameraTrack;
+
+    // Instance model matrices in slot order (grouped by component)
+    std::vector<glm::mat4> instanceMatrices;
+    std::vector<unsigned int> instanceSlots;   // Instance -> slot
+    std::vector<unsigned char> wasMoving;      // Instance moved last frame
+    std::vector<unsigned char> inMovingSet;    // Instance drawn with the moving part
+    std::vector<drawBatchT> batches;
+    GLuint instanceBuffer;
+    bool batchesDirty;
+    bool matricesDirty;
+    // Last drawn frame was taken mid animation (the settled one is still due)
+    bool drawnAnimating;
+    // Bumped whenever the static part may look different
+    unsigned int staticVersion;
+
+    // Picking: triangle hierarchy per component, instance hierarchy over
+    // the world boxes of the drawn matrices
+    std::vector<meshBvh> meshBvhs;
+    std::vector<aabbT> instanceBoxes;
+    boxBvh instanceBvh;
+    bool pickTreeDirty;                        // Boards changed, rebuild
+    bool pickBoundsDirty;                      // Matrices changed, refit
+
+    // World boxes of all the instances from the drawn matrices
+    // Inputs: None
+    // Output: None
+    void updateInstanceBoxes();
+
+    // Group the instances by component
+    // Inputs: number of components
+    // Output: None
+    void rebuildBatches(unsigned int componentCnt);
+    // Starts the animations for an applied move
+    // Inputs: board index, move result, delay in ticks
+    // Output: None
+    void animateMove(unsigned int board, const moveResultT& result, unsigned int delay);
+
+public:
+    // Constructor function
+    chessScene();
+    // destructor function
+    ~chessScene();
+    // Delete the GL objects (call while the GL context is alive)
+    // Inputs: None
+    // Output: None
+    void release();
+    // Build the boards and their tracks (camera is reset to frame the grid)
+    // Inputs: Chess components, target Model matrix specs, number of boards
+    // Output: None
+    void setupBoards(std::vector<chessComponent>& components, tModelMap& cTModelMap, unsigned int boardCnt);
+    // Applies a move to a board and animates it
+    // Inputs: board index, move string, delay in ticks
+    // Output: true if the move was applied
+    bool playMove(unsigned int board, std::string_view move, unsigned int delay);
+    // Replaces a board's position, the pieces glide to their new places
+    // Inputs: board index, position (set up from the same components)
+    // Output: true if the position was replaced
+    bool setBoard(unsigned int board, const chessBoard& position);
+    // Get a board's position
+    // Inputs: board index
+    // Output: board
+    const chessBoard& getBoard(unsigned int board) const;
+    // Moves the camera (takes the short way around)
+    // Inputs: camera spherical coordinates (theta, phi, r)
+    // Output: None
+    void moveCamera(glm::vec3 camera);
+    // Interpolated camera
+    // Inputs: blend factor
+    // Output: camera spherical coordinates (theta, phi, r)
+    glm::vec3 getCamera(float alpha) const;
+    // Runs the simulation ticks covered by the elapsed time
+    // Inputs: elapsed time (seconds)
+    // Output: number of ticks run
+    unsigned int advance(double frameTime);
+    // Blend factor between the last two ticks
+    // Inputs: None
+    // Output: blend factor
+    float getAlpha() const;
+    // Draw all the boards (one instanced draw per component)
+    // Inputs: Chess components, texture sampler uniform, blend factor
+    // Output: None
+    void renderBoards(std::vector<chessComponent>& components, GLuint TextureID, float alpha);
+    // Bring the instance matrices up to date for a frame
+    // Inputs: Chess components, blend factor
+    // Output: None
+    void updateInstances(std::vector<chessComponent>& components, float alpha);
+    // Draw a part of the boards with the current instance matrices
+    // Inputs: Chess components, texture sampler uniform, part (SCENE_DRAW_*)
+    // Output: None
+    void drawInstances(std::vector<chessComponent>& components, GLuint TextureID, unsigned int part);
+    // Grow the moving set by the instances that started moving (the set starts
+    // over with each animation, the static part is everything else)
+    // Inputs: None
+    // Output: true if the set changed
+    bool updateMovingSet();
+    // Version of the static part (changes when it has to be drawn again)
+    // Inputs: None
+    // Output: version
+    unsigned int getStaticVersion() const;
+    // Check whether the last drawn frame is out of date
+    // Inputs: None
+    // Output: true if boards, pieces or the camera changed since
+    bool needsRedraw() const;
+    // Check for a running animation
+    // Inputs: None
+    // Output: true while anything moves
+    bool isAnimating() const;
+    // Check for a camera transition
+    // Inputs: None
+    // Output: true while the camera moves
+    bool isCameraMoving() const;
+    // Closest instance along a ray (as drawn by the last renderBoards)
+    // Inputs: world space ray origin and direction, result
+    // Output: true if something was hit
+    bool pick(const glm::vec3& orig, const glm::vec3& dir, pickResultT& result);
+    // Get the number of boards
+    // Inputs: None
+    // Output: board count
+    unsigned int getBoardCount() const;
+    // Get the number of boards per grid side
+    // Inputs: None
+    // Output: grid size
+    unsigned int getGridSize() const;
+};
+
+#endif
@@ -20,9 +20,11 @@ Description :
 */
 
 // Include standard headers
+#include <algorithm>
 #include <stdio.h>
 #include <stdlib.h>
 #include <vector>
+#include <unistd.h>
 // Include GLEW
 #include <GL/glew.h>
 // Include GLFW
@@ -37,81 +39,680 @@ using namespace glm;
 #include <common/shader.hpp>
 #include <common/texture.hpp>
 #include <common/controls.hpp>
-#include <common/objloader.hpp>
 #include <common/vboindexer.hpp>
 // Lab3 specific chess class
 #include "chessComponent.h"
 #include "chessCommon.h"
+#include "chessScene.h"
+#include "chessLoader.h"
 #include "helper_functions.hpp"
-#include "linux_main.cpp"
+#include "shader_cache.hpp"
+#include "engine_stats.hpp"
+#include "command_server.hpp"
+#include "game_journal.hpp"
+#include "background_cache.hpp"
+#include "alloc_stats.hpp"
+#include "uci_engine.hpp"
 
 // Sets up the chess board
 void setupChessBoard(tModelMap& cTModelMap);
 GLuint LightSwitchID;
 GLuint LightPowerID;
 std::vector<chessComponent> gchessComponents;
+// Mesh data of all the components until it is on the GPU
+meshArena gMeshArena;
 tModelMap cTModelMap;
 GLuint MatrixID;
 GLuint ViewMatrixID;
-GLuint ModelMatrixID;
 GLuint LightID;
 GLuint TextureID;
 bool lightSwitch=true;
 float lightPower = 400.0;
 glm::mat4 newViewMatrix = getViewMatrix();
 glm::vec3 lightPos = glm::vec3(0, 0, 15);
+// Game states and their fixed timestep animations (share gchessComponents)
+chessScene gScene;
+// Board the move command plays on
+unsigned int activeBoard = 0;
+// Board counts used by the dashboard benchmark
+const unsigned int BENCH_BOARDS[] = {1, 4, 16, 36, 64, 100};
+const unsigned int BENCH_FRAMES = 120;
+// Command processing state (reused between commands)
+const unsigned int MAX_CMDS_PER_FRAME = 4096;
+cmdTokensT gCmdTokens;
+std::string moveBuffer;
+std::string engineMove;
+// Scratch position the player's moves are checked on before any is played
+chessBoard moveCheckBoard;
+// Engine process (its search output feeds gEngineStats)
+uciEngine gEngine;
+// Engine pipe latency and health metrics
+engineStats gEngineStats;
+bool quitRequested = false;
+// Socket command clients (replies are captured in replyText)
+commandServer gServer;
+std::string replyText;
+replyBuffer replyBuf(replyText);
+std::ostream replyStream(&replyBuf);
+// Where command output goes (console, or the reply of a socket client)
+std::ostream* gOut = &std::cout;
+// Moves and snapshots of every game played, for replay and scrubbing
+gameJournal gJournal;
+// Journal playback on a board (one ply per move animation)
+typedef struct
+{
+    bool active;
+    unsigned int board;
+    uint32_t game;
+    uint32_t ply;
+    uint32_t lastPly;
+    double nextTime;
+} replayT;
+replayT gReplay = {false, 0, 0, 0, 0, 0.0};
+std::string replayMove;
+// Moves played on each board from the start position. The engine keeps no
+// position of its own between requests: it is sent the active board's whole
+// list, so boards (and journal seeks) never mix their games in one session.
+std::vector<std::string> gBoardMoves;
+// Mouse picking: last drawn view projection and the selected square
+typedef struct
+{
+    bool active;
+    unsigned int board;
+    int file;
+    int rank;
+} selectionT;
+glm::mat4 gViewProjection = glm::mat4(1.0f);
+selectionT gSelection = {false, 0, -1, -1};
+bool mouseWasDown = false;
+// On demand frames: draw only when something changed, sleep otherwise
+// (the scene tracks boards, pieces and camera, viewDirty the rest)
+const double IDLE_MAX_WAIT = 1.0;          // Longest sleep (seconds)
+const double IDLE_POLL_WAIT = 0.05;        // Sleep when commands cannot wake the loop
+bool viewDirty = true;
+bool continuousFrames = false;
+commandWaker gWaker;
+// Static part of the scene kept offscreen while pieces move (--cache-background)
+bool useBackgroundCache = false;
+backgroundCache gBackground;
+unsigned int backgroundVersion = 0;
+
+void renderNextFrame(float alpha);
+
+// Light or window changed: the next frame is drawn from scratch
+// Inputs: None
+// Output: None
+void markViewDirty()
+{
+    viewDirty = true;
+    gBackground.invalidate();
+}
+
+// Window callbacks (a resized or uncovered window needs a new frame)
+void onFramebufferSize(GLFWwindow* win, int width, int height)
+{
+    markViewDirty();
+}
+
+void onWindowRefresh(GLFWwindow* win)
+{
+    markViewDirty();
+}
+
+// Sets up the dashboard, every board at the start position
+// Inputs: board count
+// Output: None
+void setupDashboard(unsigned int boardCnt)
+{
+    gScene.setupBoards(gchessComponents, cTModelMap, boardCnt);
+    gBoardMoves.assign(gScene.getBoardCount(), std::string());
+}
+
+// Shows a journal position on a board (its moves stop being recorded)
+// Inputs: board index, game, ply
+// Output: true if the position was found
+bool showJournalPly(unsigned int board, uint32_t game, uint32_t ply)
+{
+    chessBoard position = gScene.getBoard(board);
+    if (!gJournal.seek(game, ply, position) || !gScene.setBoard(board, position))
+    {
+        return false;
+    }
+    gJournal.reviewBoard(board, game, ply);
+    // The moves reaching the ply, for the engine
+    std::string& boardMoves = gBoardMoves[board];
+    boardMoves.clear();
+    for (uint32_t p = 1; p <= ply && gJournal.getMove(game, p, replayMove); p++)
+    {
+        boardMoves += ' ';
+        boardMoves += replayMove;
+    }
+    return true;
+}
+
+// Plays the next replayed ply once the previous one has landed
+// Inputs: current time
+// Output: None
+void stepReplay(double currentTime)
+{
+    if (!gReplay.active || currentTime < gReplay.nextTime)
+    {
+        return;
+    }
+    if (!gJournal.getMove(gReplay.game, gReplay.ply + 1, replayMove) ||
+        !gScene.playMove(gReplay.board, replayMove, 0))
+    {
+        gReplay.active = false;
+        return;
+    }
+    gReplay.ply++;
+    gBoardMoves[gReplay.board] += ' ';
+    gBoardMoves[gReplay.board] += replayMove;
+    gJournal.reviewBoard(gReplay.board, gReplay.game, gReplay.ply);
+    gReplay.active = (gReplay.ply < gReplay.lastPly);
+    gReplay.nextTime = currentTime + MOVE_TICKS * SIM_TICK;
+}
+
+// Command handlers (tokens[0] is the verb)
+// Inputs: command tokens
+// Output: true if the command was valid
+bool cmdBenchBoards(const cmdTokensT& cmd)
+{
+    unsigned int boardCnt = gScene.getBoardCount();
+
+    // Unthrottled frames, pieces kept moving so matrices are rebuilt every frame
+    glfwSwapInterval(0);
+    *gOut << "boards  ms/frame  us/board" << std::endl;
+    for (unsigned int n : BENCH_BOARDS)
+    {
+        gScene.setupBoards(gchessComponents, cTModelMap, n);
+        for (unsigned int b = 0; b < n; b++)
+        {
+            gScene.playMove(b, "e2e4", 0);
+            gScene.playMove(b, "e7e5", MOVE_TICKS);
+            gScene.playMove(b, "g1f3", 2 * MOVE_TICKS);
+        }
+        renderNextFrame(gScene.getAlpha());
+        glFinish();
+
+        double start = glfwGetTime();
+        for (unsigned int f = 0; f < BENCH_FRAMES; f++)
+        {
+            gScene.advance(SIM_TICK);
+            renderNextFrame(gScene.getAlpha());
+        }
+        glFinish();
+        double frameMs = 1000.0 * (glfwGetTime() - start) / BENCH_FRAMES;
+        *gOut << n << "  " << frameMs << "  " << 1000.0 * frameMs / n << std::endl;
+    }
+
+    // Back to the previous dashboard
+    setupDashboard(boardCnt);
+    activeBoard = 0;
+    gReplay.active = false;
+    gJournal.startGames(boardCnt);
+    glfwSwapInterval(1);
+    return true;
+}
+
+bool cmdBoard(const cmdTokensT& cmd)
+{
+    unsigned int board;
+    if (cmd.count < 2 || !parseUInt(cmd.tokens[1], board) || board >= gScene.getBoardCount())
+    {
+        return false;
+    }
+    activeBoard = board;
+    return true;
+}
+
+bool cmdBoards(const cmdTokensT& cmd)
+{
+    unsigned int boardCnt;
+    if (cmd.count < 2 || !parseUInt(cmd.tokens[1], boardCnt) || boardCnt < 1)
+    {
+        return false;
+    }
+    setupDashboard(boardCnt);
+    activeBoard = 0;
+    gReplay.active = false;
+    gJournal.startGames(boardCnt);
+    return true;
+}
+
+bool cmdCamera(const cmdTokensT& cmd)
+{
+    float theta, phi, r;
+    if (cmd.count < 4 || !parseFloat(cmd.tokens[1], theta) ||
+        !parseFloat(cmd.tokens[2], phi) || !parseFloat(cmd.tokens[3], r))
+    {
+        return false;
+    }
+    gScene.moveCamera(glm::vec3(theta, phi, r));
+    return true;
+}
+
+bool cmdEngineStats(const cmdTokensT& cmd)
+{
+    gEngineStats.print(*gOut);
+    return true;
+}
+
+bool cmdJournal(const cmdTokensT& cmd)
+{
+    uint32_t game, ply;
+    if (!gJournal.isOpen())
+    {
+        *gOut << "Game journal is off" << std::endl;
+        return true;
+    }
+    *gOut << "Journal: " << gJournal.getGameCount() << " games, "
+          << gJournal.getRecordCount() << " records" << std::endl;
+    if (gJournal.getBoardGame(activeBoard, game, ply))
+    {
+        *gOut << "Board " << activeBoard << ": game " << game << " ply " << ply
+              << (gJournal.isRecording(activeBoard) ? " (recording)" : " (review)") << std::endl;
+    }
+    return true;
+}
+
+bool cmdLight(const cmdTokensT& cmd)
+{
+    float theta, phi, r;
+    if (cmd.count < 4 || !parseFloat(cmd.tokens[1], theta) ||
+        !parseFloat(cmd.tokens[2], phi) || !parseFloat(cmd.tokens[3], r))
+    {
+        return false;
+    }
+    lightPos = sphericalToCartesian(theta, phi, r);
+    markViewDirty();
+    return true;
+}
+
+bool cmdMove(const cmdTokensT& cmd)
+{
+    if (cmd.count < 2)
+    {
+        return false;
+    }
+    // Every move must be legal, otherwise nothing is played (the engine
+    // would apply moves the boards dropped and the two would drift apart)
+    moveResultT result;
+    moveCheckBoard = gScene.getBoard(activeBoard);
+    // The engine gets the board's whole game ("position startpos moves
+    // <list>"), it keeps nothing between requests
+    moveBuffer = gBoardMoves[activeBoard];
+    for (unsigned int i = 1; i < cmd.count; i++)
+    {
+        if (!moveCheckBoard.applyMove(cmd.tokens[i], result))
+        {
+            *gOut << "Illegal move " << cmd.tokens[i] << std::endl;
+            return false;
+        }
+        moveBuffer += ' ';
+        moveBuffer.append(cmd.tokens[i]);
+    }
+
+    // The engine answers before anything is played, so a failed exchange
+    // leaves the board and the journal as they were
+    gEngineStats.beginRequest();
+    if (!gEngine.requestMove(moveBuffer, engineMove, gEngineStats))
+    {
+        gEngineStats.endRequest(false);
+        *gOut << "Engine request failed" << std::endl;
+        return false;
+    }
+    bool replyOk = moveCheckBoard.applyMove(engineMove, result);
+    gEngineStats.endRequest(replyOk);
+    if (!replyOk)
+    {
+        *gOut << "Engine reply " << engineMove << " cannot be played" << std::endl;
+        return false;
+    }
+
+    // Queue the moves one after the other, then the engine's reply
+    if (gReplay.board == activeBoard)
+    {
+        gReplay.active = false;
+    }
+    unsigned int delay = 0;
+    for (unsigned int i = 1; i < cmd.count; i++)
+    {
+        gScene.playMove(activeBoard, cmd.tokens[i], delay);
+        gJournal.recordMove(activeBoard, JOURNAL_PLAYER_MOVE, cmd.tokens[i], 0, gScene.getBoard(activeBoard));
+        delay += MOVE_TICKS;
+    }
+    gScene.playMove(activeBoard, engineMove, delay);
+    gJournal.recordMove(activeBoard, JOURNAL_ENGINE_MOVE, engineMove,
+                        static_cast<uint32_t>(gEngineStats.getLastRoundTripUs()), gScene.getBoard(activeBoard));
+    gBoardMoves[activeBoard] = moveBuffer;
+    gBoardMoves[activeBoard] += ' ';
+    gBoardMoves[activeBoard] += engineMove;
+    *gOut << "bestmove " << engineMove << std::endl;
+    return true;
+}
+
+bool cmdPower(const cmdTokensT& cmd)
+{
+    if (cmd.count < 2 || !parseFloat(cmd.tokens[1], lightPower))
+    {
+        return false;
+    }
+    markViewDirty();
+    return true;
+}
+
+bool cmdQuit(const cmdTokensT& cmd)
+{
+    quitRequested = true;
+    return true;
+}
+
+bool cmdReplay(const cmdTokensT& cmd)
+{
+    unsigned int game;
+    unsigned int ply = 0;
+    uint32_t lastPly;
+    if (cmd.count < 2 || !parseUInt(cmd.tokens[1], game) ||
+        (cmd.count > 2 && !parseUInt(cmd.tokens[2], ply)) ||
+        !gJournal.getLastPly(game, lastPly) || ply > lastPly ||
+        !showJournalPly(activeBoard, game, ply))
+    {
+        return false;
+    }
+    // Plies follow once the board has glided to the start position
+    gReplay = {ply < lastPly, activeBoard, game, ply, lastPly, glfwGetTime() + SEEK_TICKS * SIM_TICK};
+    return true;
+}
+
+bool cmdScrub(const cmdTokensT& cmd)
+{
+    int delta;
+    uint32_t game, ply, lastPly;
+    if (cmd.count < 2 || !parseInt(cmd.tokens[1], delta) ||
+        !gJournal.getBoardGame(activeBoard, game, ply) || !gJournal.getLastPly(game, lastPly))
+    {
+        return false;
+    }
+    int64_t target = static_cast<int64_t>(ply) + delta;
+    target = (target < 0) ? 0 : ((target > lastPly) ? lastPly : target);
+    if (gReplay.board == activeBoard)
+    {
+        gReplay.active = false;
+    }
+    return showJournalPly(activeBoard, game, static_cast<uint32_t>(target));
+}
+
+bool cmdSeek(const cmdTokensT& cmd)
+{
+    unsigned int game, ply;
+    if (cmd.count < 3 || !parseUInt(cmd.tokens[1], game) || !parseUInt(cmd.tokens[2], ply))
+    {
+        return false;
+    }
+    if (gReplay.board == activeBoard)
+    {
+        gReplay.active = false;
+    }
+    return showJournalPly(activeBoard, game, ply);
+}
+
+// Command verbs (sorted for binary search)
+constexpr cmdEntryT CMD_TABLE[] =
+{
+    {"benchboards", cmdBenchBoards},
+    {"board",       cmdBoard},
+    {"boards",      cmdBoards},
+    {"camera",      cmdCamera},
+    {"enginestats", cmdEngineStats},
+    {"journal",     cmdJournal},
+    {"light",       cmdLight},
+    {"move",        cmdMove},
+    {"power",       cmdPower},
+    {"quit",        cmdQuit},
+    {"replay",      cmdReplay},
+    {"scrub",       cmdScrub},
+    {"seek",        cmdSeek}
+};
+constexpr std::size_t CMD_TABLE_SIZE = sizeof(CMD_TABLE) / sizeof(CMD_TABLE[0]);
+static_assert(isCmdTableSorted(CMD_TABLE, CMD_TABLE_SIZE), "CMD_TABLE must be sorted by verb");
+
+bool runCommand(std::string_view line);
+
+// Click to select a piece, click a square to move it there
+// (the move goes through the move command like a typed one)
+// Inputs: None
+// Output: None
+void handleMouse()
+{
+    bool down = (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS);
+    bool clicked = down && !mouseWasDown;
+    mouseWasDown = down;
+    if (!clicked)
+    {
+        return;
+    }
+
+    // Cursor ray: unproject the near and far plane points
+    double cursorX, cursorY;
+    int width, height;
+    glfwGetCursorPos(window, &cursorX, &cursorY);
+    glfwGetWindowSize(window, &width, &height);
+    if (width <= 0 || height <= 0)
+    {
+        return;
+    }
+    float ndcX = static_cast<float>(2.0 * cursorX / width - 1.0);
+    float ndcY = static_cast<float>(1.0 - 2.0 * cursorY / height);
+    glm::mat4 invVP = glm::inverse(gViewProjection);
+    glm::vec4 nearPoint = invVP * glm::vec4(ndcX, ndcY, -1.f, 1.f);
+    glm::vec4 farPoint = invVP * glm::vec4(ndcX, ndcY, 1.f, 1.f);
+    glm::vec3 orig = glm::vec3(nearPoint) / nearPoint.w;
+    glm::vec3 dir = glm::vec3(farPoint) / farPoint.w - orig;
+
+    pickResultT hit;
+    if (!gScene.pick(orig, dir, hit) || hit.file < 0)
+    { // Clicking off the squares drops the selection
+        gSelection.active = false;
+        return;
+    }
+    char square[3] = {static_cast<char>('a' + hit.file), static_cast<char>('1' + hit.rank), '\0'};
+
+    // First click (or a click on another board) picks up a piece
+    if (!gSelection.active || gSelection.board != static_cast<unsigned int>(hit.board))
+    {
+        if (hit.piece >= 0)
+        {
+            gSelection = {true, static_cast<unsigned int>(hit.board), hit.file, hit.rank};
+            activeBoard = gSelection.board;
+            std::cout << "Selected " << square << " on board " << activeBoard << std::endl;
+        }
+        return;
+    }
+    gSelection.active = false;
+    if (gSelection.file == hit.file && gSelection.rank == hit.rank)
+    { // Same square again, put it back
+        return;
+    }
+
+    char line[16];
+    snprintf(line, sizeof(line), "move %c%c%s", 'a' + gSelection.file, '1' + gSelection.rank, square);
+    std::cout << line << std::endl;
+    activeBoard = gSelection.board;
+    runCommand(line);
+}
+
+// Tokenizes and runs a command line
+// Inputs: command line
+// Output: true if the command was valid (blank lines are)
+bool runCommand(std::string_view line)
+{
+    bool ok = false;
+    if (tokenizeInputCmd(line, gCmdTokens))
+    {
+        if (gCmdTokens.count == 0)
+        {
+            return true;
+        }
+        const cmdEntryT* entry = findCommand(CMD_TABLE, CMD_TABLE_SIZE, gCmdTokens.tokens[0]);
+        try
+        {
+            ok = (entry != nullptr && entry->handler(gCmdTokens));
+        }
+        catch (...)
+        {
+            ok = false;
+        }
+    }
+    if (!ok)
+    {
+        *gOut << "Invalid command or move!!" << std::endl;
+    }
+    return ok;
+}
 
-void renderNextFrame()
+// Runs the socket clients' commands gathered this frame and queues the replies
+// (command output followed by "ok" or "error")
+// Inputs: None
+// Output: None
+void runClientCommands()
 {
+    gServer.pollEvents();
+    gOut = &replyStream;
+    for (unsigned int rIdx = 0; rIdx < gServer.getRequestCount(); rIdx++)
+    {
+        replyText.clear();
+        bool ok = runCommand(gServer.getRequest(rIdx));
+        replyText += ok ? "ok\n" : "error\n";
+        gServer.reply(gServer.getRequestClient(rIdx), replyText);
+    }
+    gOut = &std::cout;
+    gServer.clearRequests();
+}
+
+// Draws the boards through the background cache: while pieces move under a
+// still camera, only the moving set is drawn over a copy of the static part
+// Inputs: blend factor
+// Output: false if the offscreen targets are not available
+bool renderCachedBoards(float alpha)
+{
+    int width, height;
+    glfwGetFramebufferSize(window, &width, &height);
+    if (!gBackground.resize(width, height))
+    {
+        return false;
+    }
 
-    // Clear the screen
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    bool split = gScene.isAnimating() && !gScene.isCameraMoving();
+    if (split)
+    {
+        gScene.updateMovingSet();
+    }
+    gScene.updateInstances(gchessComponents, alpha);
+    if (!split)
+    { // Full frame (the camera moves or nothing does)
+        gBackground.beginFrame(false);
+        gScene.drawInstances(gchessComponents, TextureID, SCENE_DRAW_ALL);
+        gBackground.invalidate();
+    }
+    else
+    {
+        if (!gBackground.isValid() || backgroundVersion != gScene.getStaticVersion())
+        {
+            gBackground.beginBackground();
+            gScene.drawInstances(gchessComponents, TextureID, SCENE_DRAW_STATIC);
+            backgroundVersion = gScene.getStaticVersion();
+        }
+        gBackground.beginFrame(true);
+        gScene.drawInstances(gchessComponents, TextureID, SCENE_DRAW_MOVING);
+    }
+    gBackground.present();
+    return true;
+}
 
+// Sleeps until a window event, a command or the next timed job (replay
+// step, metrics refresh), whichever comes first
+// Inputs: current time, last metrics refresh, console input still open
+// Output: None
+void waitForWork(double currentTime, double lastMetricsTime, bool stdinOpen)
+{
+    double wakeTime = lastMetricsTime + ENGINE_METRICS_PERIOD;
+    if (gReplay.active && gReplay.nextTime < wakeTime)
+    {
+        wakeTime = gReplay.nextTime;
+    }
+    double timeout = std::min(wakeTime - currentTime, IDLE_MAX_WAIT);
+
+    int fds[2];
+    unsigned int fdCnt = 0;
+    if (stdinOpen)
+    {
+        fds[fdCnt++] = STDIN_FILENO;
+    }
+    if (gServer.getPollFd() >= 0)
+    {
+        fds[fdCnt++] = gServer.getPollFd();
+    }
+    if (!gWaker.arm(fds, fdCnt))
+    {
+        timeout = std::min(timeout, IDLE_POLL_WAIT);
+    }
+    if (timeout > 0.0)
+    {
+        glfwWaitEventsTimeout(timeout);
+    }
+    else
+    {
+        glfwPollEvents();
+    }
+    gWaker.disarm();
+}
+
+void renderNextFrame(float alpha)
+{
     // Compute the VP matrix from keyboard and mouse input
     computeMatricesFromInputsLab3();
-    glm::mat4 ProjectionMatrix = getProjectionMatrix();
+    // Same projection as the controls, with the far plane stretched over the board grid
+    glm::mat4 ProjectionMatrix = glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f,
+                                                  100.0f * gScene.getGridSize());
     // newViewMatrix = getViewMatrix();
 
+    // Camera track holds (theta, phi, r), interpolated between ticks
+    glm::vec3 camera = gScene.getCamera(alpha);
+    newViewMatrix = glm::lookAt(
+        sphericalToCartesian(camera.x, camera.y, camera.z), // Camera is here
+        glm::vec3(0, 0, 0),                 // and looks here : at the same position, plus "direction"
+        glm::vec3(0, 0, 1)                  // Look in the z-direction (set to 0,0,1 to look upside-down)
+    );
+
     // Get light switch State (It's a toggle!)
     // lightSwitch = getLightSwitch();
     // Pass it to Fragment Shader
     glUniform1i(LightSwitchID, static_cast<int>(lightSwitch));
 
-    // Run through all the chess game components for rendering
-    for (auto cit = gchessComponents.begin(); cit != gchessComponents.end(); cit++)
-    {            
-        // Seach for mesh rendering targets and counts
-        tPosition cTPosition = cTModelMap[cit->getComponentID()];
-        
-        // Repeat for pair of players using repetition count
-        for (unsigned int pit = 0; pit < cTPosition.rCnt; pit++)
-        {
-            // Modify the X for player repetition
-            tPosition cTPositionMorph = cTPosition;
-            cTPositionMorph.tPos.x += pit * cTPosition.rDis * CHESS_BOX_SIZE;
-            // Pass it for Model matrix generation
-            glm::mat4 ModelMatrix = cit->genModelMatrix(cTPositionMorph);
-            // Genrate the MVP matrix
-            glm::mat4 MVP = ProjectionMatrix * newViewMatrix * ModelMatrix;
-
-            // Send our transformation to the currently bound shader, 
-            // in the "MVP" uniform
-            glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP[0][0]);
-            glUniformMatrix4fv(ModelMatrixID, 1, GL_FALSE, &ModelMatrix[0][0]);
-            glUniformMatrix4fv(ViewMatrixID, 1, GL_FALSE, &newViewMatrix[0][0]);
-
-            // Light is placed right on the top of the board
-            // with a decent height for good lighting across
-            // the board!
-            glUniform3f(LightID, lightPos.x, lightPos.y, lightPos.z);
-            glUniform1f(LightPowerID, lightPower);
-
-            // Bind our texture (set it up)
-            cit->setupTexture(TextureID);
-
-            // Render buffers
-            cit->renderMesh();
-        }
+    // Genrate the VP matrix (model matrices are per instance)
+    glm::mat4 VP = ProjectionMatrix * newViewMatrix;
+    // Kept for the mouse picking ray
+    gViewProjection = VP;
+
+    // Send our transformation to the currently bound shader, 
+    // in the "VP" uniform
+    glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &VP[0][0]);
+    glUniformMatrix4fv(ViewMatrixID, 1, GL_FALSE, &newViewMatrix[0][0]);
+
+    // Light is placed right on the top of the board
+    // with a decent height for good lighting across
+    // the board!
+    glUniform3f(LightID, lightPos.x, lightPos.y, lightPos.z);
+    glUniform1f(LightPowerID, lightPower);
+
+    // Run through all the boards for rendering (one draw per component)
+    if (!useBackgroundCache || !renderCachedBoards(alpha))
+    {
+        useBackgroundCache = false;
+        // Clear the screen
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        gScene.renderBoards(gchessComponents, TextureID, alpha);
     }
 
     // Swap buffers
@@ -119,8 +720,61 @@ void renderNextFrame()
     glfwPollEvents();
 }
 
-int main( void )
+int main( int argc, char* argv[] )
 {
+    // Command server options
+    const char* socketPath = CMD_SOCKET_PATH;
+    unsigned int tcpPort = 0;
+    bool useJournal = true;
+    // Metrics file, per process unless given (viewers can share a directory)
+    std::string metricsPath = std::string(ENGINE_METRICS_PREFIX) + "." + std::to_string(getpid()) + ".prom";
+    bool defaultMetricsPath = true;
+    bool loadStats = false;
+    for (int a = 1; a < argc; a++)
+    {
+        std::string_view arg = argv[a];
+        if (arg == "--no-journal")
+        {
+            useJournal = false;
+        }
+        else if (arg == "--cache-background")
+        {
+            useBackgroundCache = true;
+        }
+        else if (arg == "--continuous")
+        {
+            continuousFrames = true;
+        }
+        else if (ALLOC_STATS_ENABLED && arg == "--load-stats")
+        {
+            loadStats = true;
+        }
+        else if (arg == "--no-socket")
+        {
+            socketPath = nullptr;
+        }
+        else if (arg == "--socket" && a + 1 < argc)
+        {
+            socketPath = argv[++a];
+        }
+        else if (arg == "--tcp" && a + 1 < argc && parseUInt(argv[a + 1], tcpPort) && tcpPort < 65536)
+        {
+            a++;
+        }
+        else if (arg == "--metrics" && a + 1 < argc)
+        {
+            metricsPath = argv[++a];
+            defaultMetricsPath = false;
+        }
+        else
+        {
+            fprintf(stderr, "Usage: %s [--socket PATH | --no-socket] [--tcp PORT] [--no-journal]"
+                            " [--metrics PATH] [--cache-background] [--continuous]%s\n", argv[0],
+                    ALLOC_STATS_ENABLED ? " [--load-stats]" : "");
+            return -1;
+        }
+    }
+
     // Initialize GLFW
     if( !glfwInit() )
     {
@@ -129,7 +783,8 @@ int main( void )
         return -1;
     }
 
-    glfwWindowHint(GLFW_SAMPLES, 4);
+    // The background cache multisamples offscreen and resolves into the window
+    glfwWindowHint(GLFW_SAMPLES, useBackgroundCache ? 0 : 4);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE); // To make macOS happy; should not be needed
@@ -144,6 +799,8 @@ int main( void )
         return -1;
     }
     glfwMakeContextCurrent(window);
+    // Pace the frames on vblank
+    glfwSwapInterval(1);
 
     // Initialize GLEW
     glewExperimental = true; // Needed for core profile
@@ -156,8 +813,13 @@ int main( void )
 
     // Ensure we can capture the escape key being pressed below
     glfwSetInputMode(window, GLFW_STICKY_KEYS, GL_TRUE);
-    // Hide the mouse and enable unlimited movement
-    // glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    // Keep the mouse visible for picking (click a piece, then its target square)
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+    // Clicks shorter than an idle wakeup still register
+    glfwSetInputMode(window, GLFW_STICKY_MOUSE_BUTTONS, GL_TRUE);
+    // Frames are drawn on demand, redraw when the window needs it
+    glfwSetFramebufferSizeCallback(window, onFramebufferSize);
+    glfwSetWindowRefreshCallback(window, onWindowRefresh);
     
     // Set the mouse at the center of the screen
     glfwPollEvents();
@@ -179,12 +841,18 @@ int main( void )
     glBindVertexArray(VertexArrayID);
 
     // Create and compile our GLSL program from the shaders
-    GLuint programID = LoadShaders( "StandardShading.vertexshader", "StandardShading.fragmentshader" );
+    // (reuses the cached program binary when the driver accepts it)
+    GLuint programID = loadCachedShaders( "StandardShading.vertexshader", "StandardShading.fragmentshader", "" );
+    if (programID == 0)
+    {
+        fprintf(stderr, "Failed to build the shader program\n");
+        glfwTerminate();
+        return -1;
+    }
 
-    // Get a handle for our "MVP" uniform
-    MatrixID = glGetUniformLocation(programID, "MVP");
+    // Get a handle for our "VP" uniform
+    MatrixID = glGetUniformLocation(programID, "VP");
     ViewMatrixID = glGetUniformLocation(programID, "V");
-    ModelMatrixID = glGetUniformLocation(programID, "M");
 
     // Get a handle for our "myTextureSampler" uniform
     TextureID  = glGetUniformLocation(programID, "myTextureSampler");
@@ -196,20 +864,41 @@ int main( void )
     // Create a vector of chess components class
     // Each component is fully self sufficient
 
-    // Load the OBJ files
-    bool cBoard = loadAssImpLab3("Lab3/Stone_Chess_Board/12951_Stone_Chess_Board_v1_L3.obj", gchessComponents);
-    bool cComps = loadAssImpLab3("Lab3/Chess/chess-mod.obj", gchessComponents);
+    // Load the OBJ files (mesh data of both in one arena block)
+    const std::vector<std::string> objFiles =
+    {
+        "Lab3/Stone_Chess_Board/12951_Stone_Chess_Board_v1_L3.obj",
+        "Lab3/Chess/chess-mod.obj"
+    };
+
+    // Cooked meshes and textures (run asset_cook to build the bundle)
+    assetBundle bundle;
+    if (!bundle.open(ASSET_BUNDLE_FILE))
+    {
+        std::cout << "No asset bundle found, loading the OBJ meshes and BMP textures" << std::endl;
+    }
+
+    // Heap use of the load (AssImp included) and of the upload below
+    resetAllocPeak();
+    allocStatsT loadStart = getAllocStats();
 
     // Proceed iff OBJ loading is successful
-    if (!cBoard || !cComps)
+    if (!loadChessComponents(objFiles, gchessComponents, gMeshArena, bundle))
     {
         // Quit the program (Failed OBJ loading)
         std::cout << "Program failed due to OBJ loading failure, please CHECK!" << std::endl;
         return -1;
     }
+    if (loadStats)
+    {
+        printAllocStats(std::cout, "OBJ loading", loadStart, getAllocStats());
+    }
 
     // Setup the Chess board locations
     setupChessBoard(cTModelMap);
+    // Build the board instances and their animation tracks (one board to start with)
+    // The picking hierarchies copy the meshes here, before the mesh data is dropped
+    setupDashboard(1);
 
     // Load it into a VBO (One time activity)
     // Run through all the components for rendering
@@ -218,7 +907,19 @@ int main( void )
         // Setup VBO buffers
         cit->setupGLBuffers();
         // Setup Texture
-        cit->setupTextureBuffers();
+        cit->setupTextureBuffers(bundle);
+    }
+    // Textures are on the GPU, drop the mapping
+    bundle.close();
+    // Meshes are on the GPU too, drop their storage
+    for (auto cit = gchessComponents.begin(); cit != gchessComponents.end(); cit++)
+    {
+        cit->releaseMeshData();
+    }
+    gMeshArena.release();
+    if (loadStats)
+    {
+        printAllocStats(std::cout, "Loading to mesh release", loadStart, getAllocStats());
     }
 
     // Use our shader (Not changing the shader per chess component)
@@ -227,83 +928,121 @@ int main( void )
     // Get a handle for our "LightPosition" uniform
     LightID = glGetUniformLocation(programID, "LightPosition_worldspace");
 
-    // For speed computation
+    // Simulation clock (decoupled from the frame rate)
     double lastTime = glfwGetTime();
-    int nbFrames = 0;
-    std::string cmd;
-    std::vector<std::string> parsed_cmd;
-    newViewMatrix = glm::lookAt(
-                glm::vec3(10, 10, 10),                           // Camera is here
-                glm::vec3(0, 0, 0),                 // and looks here : at the same position, plus "direction"
-                glm::vec3(0, 0, 1)                  // Look in the z-direction (set to 0,0,1 to look upside-down)
-            );
-    ECE_Chess_Engine engine;
-    engine.InitializeEngine();
+    double lastMetricsTime = lastTime;
+    // Console lines (read in chunks, so script files are drained without
+    // polling per line, and a partial line never blocks the frame)
+    lineReader console(STDIN_FILENO);
+    std::string_view cmd;
+    moveBuffer.reserve(1024);
+    // A missing engine is not fatal, every move request tries to start it
+    gEngine.start(UCI_ENGINE_PATH);
+    // Socket front end (one line per command, same verbs as the console)
+    if (socketPath != nullptr && gServer.listenUnix(socketPath))
+    {
+        std::cout << "Accepting commands on " << socketPath << std::endl;
+    }
+    if (tcpPort != 0 && gServer.listenTcp(static_cast<unsigned short>(tcpPort)))
+    {
+        std::cout << "Accepting commands on 127.0.0.1:" << tcpPort << std::endl;
+    }
+    // Console and socket input wake the loop while it sleeps
+    if (!continuousFrames && !gWaker.start(glfwPostEmptyEvent))
+    {
+        std::cout << "No command watcher, polling while idle" << std::endl;
+    }
+    bool stdinOpen = true;
+    // Game journal (one game per board, restarted with the boards)
+    if (useJournal && gJournal.open(GAME_JOURNAL_FILE, GAME_JOURNAL_INDEX_FILE))
+    {
+        std::cout << "Recording games to " << GAME_JOURNAL_FILE << std::endl;
+    }
+    gJournal.startGames(gScene.getBoardCount());
 
+    std::cout << "Please enter a command: " << std::endl;
     do
     {
-       renderNextFrame();
-        
-        std::cout << "Please enter a command: " << std::endl;
-        std::getline(std::cin, cmd);
-        parsed_cmd = parseInputCmd(cmd);
-        
-        try
+        // Run the fixed ticks covered by the elapsed time
+        double currentTime = glfwGetTime();
+        gScene.advance(currentTime - lastTime);
+        lastTime = currentTime;
+        // Journal playback
+        stepReplay(currentTime);
+        // Render in between ticks, only when the last frame is out of date
+        bool drawn = continuousFrames || viewDirty || gScene.needsRedraw();
+        if (drawn)
         {
-            if (parsed_cmd[0] == "light")
-            {
-                float theta = std::stof(parsed_cmd[1]);
-                float phi = std::stof(parsed_cmd[2]);
-                float r = std::stof(parsed_cmd[3]);
-                float posX = r * sin(glm::radians(theta)) * cos(glm::radians(phi));
-                float posY = r * sin(glm::radians(theta)) * sin(glm::radians(phi));
-                float posZ = r * cos(glm::radians(theta));
-                lightPos = glm::vec3(posX, posY, posZ);
-            }
-            else if (parsed_cmd[0] == "power")
-            {
-                lightPower = std::stof(parsed_cmd[1]);
-            }
-            else if (parsed_cmd[0] == "camera")
+            viewDirty = false;
+            renderNextFrame(gScene.getAlpha());
+        }
+        // Mouse clicks pick against what was last drawn
+        handleMouse();
+
+        // Refresh the engine metrics file
+        if (currentTime - lastMetricsTime >= ENGINE_METRICS_PERIOD)
+        {
+            gEngineStats.writePrometheus(metricsPath.c_str());
+            lastMetricsTime = currentTime;
+        }
+
+        // Socket clients, batched once per frame
+        runClientCommands();
+
+        // Run the pending console commands (bounded so rendering keeps up)
+        unsigned int cmdCnt = 0;
+        while (stdinOpen && cmdCnt < MAX_CMDS_PER_FRAME && !quitRequested &&
+               console.nextLine(cmd))
+        {
+            runCommand(cmd);
+            cmdCnt++;
+        }
+        // Input closed (socket clients can still drive the viewer)
+        stdinOpen = console.isOpen();
+        if (cmdCnt > 0 && !quitRequested)
+        {
+            std::cout << "Please enter a command: " << std::endl;
+        }
+
+        // Nothing changed and no input left: sleep rather than redraw the same frame
+        if (!drawn)
+        {
+            bool inputPending = (cmdCnt == MAX_CMDS_PER_FRAME) ||
+                                (stdinOpen && console.hasLine());
+            if (!quitRequested && !inputPending && !viewDirty && !gScene.needsRedraw())
             {
-                float theta = std::stof(parsed_cmd[1]);
-                float phi = std::stof(parsed_cmd[2]);
-                float r = std::stof(parsed_cmd[3]);
-                float posX = r * sin(glm::radians(theta)) * cos(glm::radians(phi));
-                float posY = r * sin(glm::radians(theta)) * sin(glm::radians(phi));
-                float posZ = r * cos(glm::radians(theta));
-                glm::vec3 position = glm::vec3(posX, posY, posZ);
-                newViewMatrix = glm::lookAt(
-                    position,                           // Camera is here
-                    glm::vec3(0, 0, 0),                 // and looks here : at the same position, plus "direction"
-                    glm::vec3(0, 0, 1)                  // Look in the z-direction (set to 0,0,1 to look upside-down)
-                );
+                waitForWork(currentTime, lastMetricsTime, stdinOpen);
+                // Idle time is not simulated, the next transition starts on its first tick
+                lastTime = glfwGetTime();
             }
-            else if (parsed_cmd[0] == "quit")
-                return 0;
-            else if (parsed_cmd[0] == "move")
+            else
             {
-                std::string allmoves;
-                for (int i = 1; i < parsed_cmd.size(); i++)
-                {
-                    allmoves += " " + parsed_cmd[i];
-                }
-                engine.sendMove(allmoves);
-                engine.getResponseMove(allmoves);
+                glfwPollEvents();
             }
-            else
-                std::cout << "Invalid command or move!!" << std::endl;
-        }
-        catch (...)
-        {
-            std::cout << "Invalid command or move!!" << std::endl;
         }
 
     } // Check if the ESC key was pressed or the window was closed
-    while( glfwGetKey(window, GLFW_KEY_ESCAPE ) != GLFW_PRESS &&
+    while( !quitRequested &&
+           glfwGetKey(window, GLFW_KEY_ESCAPE ) != GLFW_PRESS &&
            glfwWindowShouldClose(window) == 0 );
 
-    // Cleanup VBO, Texture (Done in class destructor) and shader 
+    // Stop watching the command inputs, then drop the socket clients
+    gWaker.stop();
+    gServer.closeAll();
+    // Index this session's games
+    gJournal.close();
+    // A per process metrics file would only pile up once the viewer is gone
+    if (defaultMetricsPath)
+    {
+        unlink(metricsPath.c_str());
+    }
+
+    // Cleanup VBO, Texture (Done in class destructor), instance buffer and shader
+    // while the context is alive (the scene is a global, it outlives glfwTerminate)
+    gchessComponents.clear();
+    gScene.release();
+    // Offscreen targets go with the context too (the global outlives glfwTerminate)
+    gBackground.release();
     glDeleteProgram(programID);
     glDeleteVertexArrays(1, &VertexArrayID);
 
@@ -315,37 +1054,41 @@ int main( void )
 
 void setupChessBoard(tModelMap& cTModelMap)
 {
+    // Specs are keyed by the interned component names
+    nameTable& names = getComponentNames();
+    auto id = [&names](const char* cName) { return names.intern(cName); };
+
     // Target spec Hash
     cTModelMap =
     {
-        // Chess board              Count  rDis Angle      Axis             Scale                          Position (X, Y, Z)
-        {"12951_Stone_Chess_Board", {1,    0,   0.f,    {1, 0, 0},    glm::vec3(CBSCALE), {0.f,     0.f,                             PHEIGHT}}},
-        // First player             Count  rDis Angle      Axis             Scale                          Position (X, Y, Z)
-        {"TORRE3",                  {2,   (8-1),90.f,   {1, 0, 0},    glm::vec3(CPSCALE), {-3.5*CHESS_BOX_SIZE, -3.5*CHESS_BOX_SIZE, PHEIGHT}}},
-        {"Object3",                 {2,   (6-1),90.f,   {1, 0, 0},    glm::vec3(CPSCALE), {-2.5*CHESS_BOX_SIZE, -3.5*CHESS_BOX_SIZE, PHEIGHT}}},
-        {"ALFIERE3",                {2,   (4-1),90.f,   {1, 0, 0},    glm::vec3(CPSCALE), {-1.5*CHESS_BOX_SIZE, -3.5*CHESS_BOX_SIZE, PHEIGHT}}},
-        {"REGINA2",                 {1,    0,   90.f,   {1, 0, 0},    glm::vec3(CPSCALE), {-0.5*CHESS_BOX_SIZE, -3.5*CHESS_BOX_SIZE, PHEIGHT}}},
-        {"RE2",                     {1,    0,   90.f,   {1, 0, 0},    glm::vec3(CPSCALE), { 0.5*CHESS_BOX_SIZE, -3.5*CHESS_BOX_SIZE, PHEIGHT}}},
-        {"PEDONE13",                {8,    1,   90.f,   {1, 0, 0},    glm::vec3(CPSCALE), {-3.5*CHESS_BOX_SIZE, -2.5*CHESS_BOX_SIZE, PHEIGHT}}}
+        // Chess board                  Count  rDis Angle      Axis             Scale                          Position (X, Y, Z)
+        {id("12951_Stone_Chess_Board"), {1,    0,   0.f,    {1, 0, 0},    glm::vec3(CBSCALE), {0.f,     0.f,                             PHEIGHT}}},
+        // First player                 Count  rDis Angle      Axis             Scale                          Position (X, Y, Z)
+        {id("TORRE3"),                  {2,   (8-1),90.f,   {1, 0, 0},    glm::vec3(CPSCALE), {-3.5*CHESS_BOX_SIZE, -3.5*CHESS_BOX_SIZE, PHEIGHT}}},
+        {id("Object3"),                 {2,   (6-1),90.f,   {1, 0, 0},    glm::vec3(CPSCALE), {-2.5*CHESS_BOX_SIZE, -3.5*CHESS_BOX_SIZE, PHEIGHT}}},
+        {id("ALFIERE3"),                {2,   (4-1),90.f,   {1, 0, 0},    glm::vec3(CPSCALE), {-1.5*CHESS_BOX_SIZE, -3.5*CHESS_BOX_SIZE, PHEIGHT}}},
+        {id("REGINA2"),                 {1,    0,   90.f,   {1, 0, 0},    glm::vec3(CPSCALE), {-0.5*CHESS_BOX_SIZE, -3.5*CHESS_BOX_SIZE, PHEIGHT}}},
+        {id("RE2"),                     {1,    0,   90.f,   {1, 0, 0},    glm::vec3(CPSCALE), { 0.5*CHESS_BOX_SIZE, -3.5*CHESS_BOX_SIZE, PHEIGHT}}},
+        {id("PEDONE13"),                {8,    1,   90.f,   {1, 0, 0},    glm::vec3(CPSCALE), {-3.5*CHESS_BOX_SIZE, -2.5*CHESS_BOX_SIZE, PHEIGHT}}}
     };
 
     // Second player derived from first player!!
     // Second Player (TORRE02)
-    cTModelMap["TORRE02"] = cTModelMap["TORRE3"];
-    cTModelMap["TORRE02"].tPos.y = -cTModelMap["TORRE3"].tPos.y;
+    cTModelMap[id("TORRE02")] = cTModelMap[id("TORRE3")];
+    cTModelMap[id("TORRE02")].tPos.y = -cTModelMap[id("TORRE3")].tPos.y;
     // Second Player (Object02)
-    cTModelMap["Object02"] = cTModelMap["Object3"];
-    cTModelMap["Object02"].tPos.y = -cTModelMap["Object3"].tPos.y;
+    cTModelMap[id("Object02")] = cTModelMap[id("Object3")];
+    cTModelMap[id("Object02")].tPos.y = -cTModelMap[id("Object3")].tPos.y;
     // Second Player (ALFIERE02)
-    cTModelMap["ALFIERE02"] = cTModelMap["ALFIERE3"];
-    cTModelMap["ALFIERE02"].tPos.y = -cTModelMap["ALFIERE3"].tPos.y;
+    cTModelMap[id("ALFIERE02")] = cTModelMap[id("ALFIERE3")];
+    cTModelMap[id("ALFIERE02")].tPos.y = -cTModelMap[id("ALFIERE3")].tPos.y;
     // Second Player (REGINA01)
-    cTModelMap["REGINA01"] = cTModelMap["REGINA2"];
-    cTModelMap["REGINA01"].tPos.y = -cTModelMap["REGINA2"].tPos.y;
+    cTModelMap[id("REGINA01")] = cTModelMap[id("REGINA2")];
+    cTModelMap[id("REGINA01")].tPos.y = -cTModelMap[id("REGINA2")].tPos.y;
     // Second Player (RE01)
-    cTModelMap["RE01"] = cTModelMap["RE2"];
-    cTModelMap["RE01"].tPos.y = -cTModelMap["RE2"].tPos.y;
+    cTModelMap[id("RE01")] = cTModelMap[id("RE2")];
+    cTModelMap[id("RE01")].tPos.y = -cTModelMap[id("RE2")].tPos.y;
     // Second Player (PEDONE12)
-    cTModelMap["PEDONE12"] = cTModelMap["PEDONE13"];
-    cTModelMap["PEDONE12"].tPos.y = -cTModelMap["PEDONE13"].tPos.y;
+    cTModelMap[id("PEDONE12")] = cTModelMap[id("PEDONE13")];
+    cTModelMap[id("PEDONE12")].tPos.y = -cTModelMap[id("PEDONE13")].tPos.y;
 }
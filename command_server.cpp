@@ -0,0 +1,629 @@
+#include "command_server.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+replyBuffer::replyBuffer(std::string& text)
+{
+    this->text = &text;
+}
+
+replyBuffer::int_type replyBuffer::overflow(int_type c)
+{
+    if (c != traits_type::eof())
+    {
+        text->push_back(static_cast<char>(c));
+    }
+    return c;
+}
+
+std::streamsize replyBuffer::xsputn(const char* s, std::streamsize n)
+{
+    text->append(s, static_cast<std::size_t>(n));
+    return n;
+}
+
+static bool setNonBlocking(int fd)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+// Removes a socket file nobody listens on any more. Fails if a live server
+// answers on it, or if the path is not a socket, which is never removed.
+static bool removeStaleSocket(const sockaddr_un& addr)
+{
+    int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (probe < 0)
+    {
+        return false;
+    }
+    int err = 0;
+    if (connect(probe, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0)
+    {
+        err = errno;
+    }
+    close(probe);
+
+    if (err == 0)
+    {
+        std::cout << "Another viewer is listening on " << addr.sun_path << std::endl;
+        return false;
+    }
+    if (err == ENOENT)
+    {
+        return true;
+    }
+    struct stat st;
+    if (err == ECONNREFUSED && lstat(addr.sun_path, &st) == 0)
+    {
+        if (!S_ISSOCK(st.st_mode))
+        {
+            std::cout << "Cannot listen on " << addr.sun_path << ": not a socket" << std::endl;
+            return false;
+        }
+        // Left behind by a run that did not shut down cleanly
+        return unlink(addr.sun_path) == 0 || errno == ENOENT;
+    }
+    std::cout << "Cannot listen on " << addr.sun_path << ": " << std::strerror(err) << std::endl;
+    return false;
+}
+
+static uint64_t makeClientId(const cmdClientT& client)
+{
+    return (static_cast<uint64_t>(client.generation) << 32) | static_cast<uint32_t>(client.fd);
+}
+
+commandServer::commandServer()
+{
+    epollFd = -1;
+    unixFd = -1;
+    tcpFd = -1;
+    nextGeneration = 1;
+    readBuf.resize(CMD_READ_CHUNK);
+}
+
+commandServer::~commandServer()
+{
+    closeAll();
+}
+
+bool commandServer::ensureEpoll()
+{
+    if (epollFd < 0)
+    {
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+    }
+    return epollFd >= 0;
+}
+
+bool commandServer::addListener(int fd)
+{
+    epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    return setNonBlocking(fd) && listen(fd, SOMAXCONN) == 0 &&
+           epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) == 0;
+}
+
+bool commandServer::listenUnix(const char* path)
+{
+    sockaddr_un addr = {};
+    if (!ensureEpoll() || std::strlen(path) >= sizeof(addr.sun_path))
+    {
+        return false;
+    }
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+
+    if (!removeStaleSocket(addr))
+    {
+        return false;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        return false;
+    }
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || !addListener(fd))
+    {
+        std::cout << "Cannot listen on " << path << ": " << std::strerror(errno) << std::endl;
+        close(fd);
+        return false;
+    }
+    unixFd = fd;
+    unixPath = path;
+    return true;
+}
+
+bool commandServer::listenTcp(unsigned short port)
+{
+    if (!ensureEpoll())
+    {
+        return false;
+    }
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        return false;
+    }
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    // Local clients only
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || !addListener(fd))
+    {
+        std::cout << "Cannot listen on 127.0.0.1:" << port << ": " << std::strerror(errno) << std::endl;
+        close(fd);
+        return false;
+    }
+    tcpFd = fd;
+    return true;
+}
+
+void commandServer::acceptClients(int listenFd)
+{
+    while (true)
+    {
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+        {
+            return;
+        }
+        if (static_cast<std::size_t>(fd) >= clients.size())
+        {
+            clients.resize(fd + 1);
+        }
+        cmdClientT& client = clients[fd];
+        client.fd = fd;
+        client.generation = nextGeneration++;
+        client.open = true;
+        client.wantWrite = false;
+        client.discarding = false;
+        client.inBuf.clear();
+        client.outBuf.clear();
+
+        epoll_event ev = {};
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.fd = fd;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) != 0)
+        {
+            closeClient(client);
+        }
+    }
+}
+
+void commandServer::readClient(cmdClientT& client)
+{
+    ssize_t got = recv(client.fd, readBuf.data(), readBuf.size(), 0);
+    if (got == 0 || (got < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+    {
+        closeClient(client);
+        return;
+    }
+    if (got < 0)
+    {
+        return;
+    }
+
+    // Split the complete lines out of the stream
+    std::size_t start = 0;
+    for (std::size_t i = 0; i < static_cast<std::size_t>(got); i++)
+    {
+        if (readBuf[i] != '\n')
+        {
+            continue;
+        }
+        if (client.discarding)
+        { // End of an overlong line
+            client.discarding = false;
+        }
+        else
+        {
+            client.inBuf.append(&readBuf[start], i - start);
+            cmdRequestT request = {makeClientId(client),
+                                   static_cast<uint32_t>(requestText.size()),
+                                   static_cast<uint32_t>(client.inBuf.size())};
+            requestText += client.inBuf;
+            requests.push_back(request);
+        }
+        client.inBuf.clear();
+        start = i + 1;
+    }
+    if (!client.discarding)
+    {
+        client.inBuf.append(&readBuf[start], got - start);
+    }
+    if (client.inBuf.size() > CMD_MAX_LINE)
+    {
+        client.inBuf.clear();
+        client.discarding = true;
+        reply(makeClientId(client), "error line too long\n");
+    }
+}
+
+void commandServer::flushClient(cmdClientT& client)
+{
+    std::size_t sent = 0;
+    while (sent < client.outBuf.size())
+    {
+        ssize_t n = send(client.fd, client.outBuf.data() + sent, client.outBuf.size() - sent, MSG_NOSIGNAL);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+            {
+                closeClient(client);
+                return;
+            }
+            break;
+        }
+        sent += static_cast<std::size_t>(n);
+    }
+    client.outBuf.erase(0, sent);
+
+    // Only ask for EPOLLOUT while something is pending
+    bool wantWrite = !client.outBuf.empty();
+    if (wantWrite != client.wantWrite)
+    {
+        epoll_event ev = {};
+        ev.events = EPOLLIN | EPOLLRDHUP | (wantWrite ? static_cast<uint32_t>(EPOLLOUT) : 0U);
+        ev.data.fd = client.fd;
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, client.fd, &ev);
+        client.wantWrite = wantWrite;
+    }
+}
+
+void commandServer::closeClient(cmdClientT& client)
+{
+    if (!client.open)
+    {
+        return;
+    }
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, client.fd, nullptr);
+    close(client.fd);
+    client.open = false;
+    client.inBuf.clear();
+    client.outBuf.clear();
+}
+
+void commandServer::pollEvents()
+{
+    if (epollFd < 0)
+    {
+        return;
+    }
+
+    int ready = epoll_wait(epollFd, events, CMD_MAX_EVENTS, 0);
+    for (int e = 0; e < ready; e++)
+    {
+        int fd = events[e].data.fd;
+        if (fd == unixFd || fd == tcpFd)
+        {
+            acceptClients(fd);
+            continue;
+        }
+        if (static_cast<std::size_t>(fd) >= clients.size() || !clients[fd].open)
+        {
+            continue;
+        }
+        cmdClientT& client = clients[fd];
+        if (events[e].events & EPOLLOUT)
+        {
+            flushClient(client);
+        }
+        if (client.open && (events[e].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)))
+        {
+            readClient(client);
+        }
+    }
+}
+
+unsigned int commandServer::getRequestCount() const
+{
+    return static_cast<unsigned int>(requests.size());
+}
+
+std::string_view commandServer::getRequest(unsigned int rIdx) const
+{
+    return std::string_view(requestText).substr(requests[rIdx].offset, requests[rIdx].length);
+}
+
+uint64_t commandServer::getRequestClient(unsigned int rIdx) const
+{
+    return requests[rIdx].clientId;
+}
+
+void commandServer::clearRequests()
+{
+    requestText.clear();
+    requests.clear();
+}
+
+void commandServer::reply(uint64_t clientId, std::string_view text)
+{
+    std::size_t fd = static_cast<uint32_t>(clientId);
+    if (fd >= clients.size() || !clients[fd].open ||
+        clients[fd].generation != static_cast<uint32_t>(clientId >> 32))
+    {
+        return;
+    }
+    cmdClientT& client = clients[fd];
+    client.outBuf.append(text);
+    flushClient(client);
+}
+
+int commandServer::getPollFd() const
+{
+    return (unixFd >= 0 || tcpFd >= 0) ? epollFd : -1;
+}
+
+void commandServer::closeAll()
+{
+    for (auto& client : clients)
+    {
+        closeClient(client);
+    }
+    if (unixFd >= 0)
+    {
+        close(unixFd);
+        unlink(unixPath.c_str());
+        unixFd = -1;
+    }
+    if (tcpFd >= 0)
+    {
+        close(tcpFd);
+        tcpFd = -1;
+    }
+    if (epollFd >= 0)
+    {
+        close(epollFd);
+        epollFd = -1;
+    }
+}
+
+lineReader::lineReader(int fd)
+{
+    this->fd = fd;
+    start = 0;
+    open = true;
+    discarding = false;
+    readBuf.resize(CMD_READ_CHUNK);
+}
+
+void lineReader::readAvailable()
+{
+    pollfd pfd = {fd, POLLIN, 0};
+    if (poll(&pfd, 1, 0) <= 0)
+    {
+        return;
+    }
+    // One read cannot block once poll reported the descriptor
+    ssize_t got = read(fd, readBuf.data(), readBuf.size());
+    if (got == 0 || (got < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+    {
+        open = false;
+        return;
+    }
+    if (got < 0)
+    {
+        return;
+    }
+    // Lines handed out are dropped before the buffer grows
+    buf.erase(0, start);
+    start = 0;
+    buf.append(readBuf.data(), static_cast<std::size_t>(got));
+}
+
+bool lineReader::nextLine(std::string_view& line)
+{
+    std::size_t end = buf.find('\n', start);
+    if (end == std::string::npos && open)
+    {
+        readAvailable();
+        end = buf.find('\n', start);
+    }
+    while (discarding && end != std::string::npos)
+    { // End of an overlong line
+        discarding = false;
+        start = end + 1;
+        end = buf.find('\n', start);
+    }
+    if (end == std::string::npos)
+    {
+        if (discarding || buf.size() - start > CMD_MAX_LINE)
+        {
+            if (!discarding)
+            {
+                std::cout << "Command line too long, dropped" << std::endl;
+            }
+            discarding = open;
+            buf.clear();
+            start = 0;
+            return false;
+        }
+        if (open || start == buf.size())
+        {
+            return false;
+        }
+        end = buf.size();
+    }
+    line = std::string_view(buf).substr(start, end - start);
+    start = (end < buf.size()) ? end + 1 : end;
+    return true;
+}
+
+bool lineReader::hasLine() const
+{
+    return buf.find('\n', start) != std::string::npos || (!open && start < buf.size());
+}
+
+bool lineReader::isOpen() const
+{
+    return open || start < buf.size();
+}
+
+commandWaker::commandWaker()
+{
+    nudgeFds[0] = -1;
+    nudgeFds[1] = -1;
+    armCnt = 0;
+    armed = false;
+    stopping = false;
+    wakeFn = nullptr;
+}
+
+commandWaker::~commandWaker()
+{
+    stop();
+}
+
+bool commandWaker::start(void (*wake)())
+{
+    if (watcher.joinable() || pipe2(nudgeFds, O_CLOEXEC | O_NONBLOCK) != 0)
+    {
+        return false;
+    }
+    wakeFn = wake;
+    stopping = false;
+    watcher = std::thread(&commandWaker::watchLoop, this);
+    return true;
+}
+
+void commandWaker::stop()
+{
+    if (watcher.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stopping = true;
+        }
+        armedCv.notify_one();
+        nudge();
+        watcher.join();
+    }
+    for (int& fd : nudgeFds)
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+            fd = -1;
+        }
+    }
+}
+
+void commandWaker::nudge()
+{
+    char byte = 0;
+    ssize_t n = write(nudgeFds[1], &byte, 1);
+    (void)n; // A full pipe already holds a nudge
+}
+
+bool commandWaker::arm(const int* fds, unsigned int fdCnt)
+{
+    if (!watcher.joinable())
+    {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        watchFds.assign(fds, fds + fdCnt);
+        armCnt++;
+        armed = true;
+    }
+    armedCv.notify_one();
+    // The watcher may still be polling for an earlier arm
+    nudge();
+    return true;
+}
+
+void commandWaker::disarm()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    armed = false;
+}
+
+void commandWaker::watchLoop()
+{
+    uint64_t seen = 0;
+    std::vector<pollfd> pfds;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            armedCv.wait(lock, [&] { return stopping || (armed && armCnt != seen); });
+            if (stopping)
+            {
+                return;
+            }
+            seen = armCnt;
+            pfds.clear();
+            pfds.push_back({nudgeFds[0], POLLIN, 0});
+            for (int fd : watchFds)
+            {
+                if (std::find(closedFds.begin(), closedFds.end(), fd) == closedFds.end())
+                {
+                    pfds.push_back({fd, POLLIN, 0});
+                }
+            }
+        }
+
+        // Poll until a watched descriptor is ready or the arm is over
+        bool done = false;
+        while (!done)
+        {
+            int ready = poll(pfds.data(), pfds.size(), -1);
+            if (ready < 0)
+            {
+                continue;
+            }
+            if (pfds[0].revents != 0)
+            { // Stop, disarm or a new arm (or a nudge left from one)
+                char drain[64];
+                while (read(nudgeFds[0], drain, sizeof(drain)) > 0)
+                {
+                }
+                ready--;
+            }
+            // A hung up descriptor stays ready forever: it wakes the loop once
+            // (so its reader sees the end of input) and is not watched again
+            for (std::size_t p = 1; p < pfds.size(); p++)
+            {
+                short revents = pfds[p].revents;
+                if ((revents & POLLNVAL) || ((revents & POLLHUP) && !(revents & POLLIN)))
+                {
+                    closedFds.push_back(pfds[p].fd);
+                    pfds[p].fd = -1;
+                    ready -= (revents & POLLNVAL) ? 1 : 0;
+                }
+            }
+            std::lock_guard<std::mutex> lock(mtx);
+            if (stopping || !armed || armCnt != seen)
+            {
+                done = true;
+            }
+            else if (ready > 0)
+            {
+                armed = false;
+                wakeFn();
+                done = true;
+            }
+        }
+    }
+}
@@ -0,0 +1,169 @@
+#ifndef COMMAND_SERVER_HPP
+#define COMMAND_SERVER_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <sys/epoll.h>
+
+// Default Unix domain socket (relative to the working directory)
+#define CMD_SOCKET_PATH "chess_3D_view.sock"
+// Longest accepted command line (bytes)
+const std::size_t CMD_MAX_LINE = 64 * 1024;
+// Bytes read per client per frame (keeps one client from starving the frame)
+const std::size_t CMD_READ_CHUNK = 16 * 1024;
+// Events handled per epoll_wait
+const int CMD_MAX_EVENTS = 256;
+
+// Stream buffer appending to a reused string (command replies)
+class replyBuffer : public std::streambuf
+{
+private:
+    std::string* text;
+
+protected:
+    int_type overflow(int_type c) override;
+    std::streamsize xsputn(const char* s, std::streamsize n) override;
+
+public:
+    explicit replyBuffer(std::string& text);
+};
+
+// A connected client
+typedef struct
+{
+    int fd;
+    uint32_t generation;       // Distinguishes clients reusing the same fd
+    bool open;
+    bool wantWrite;            // Waiting for EPOLLOUT
+    bool discarding;           // Dropping an overlong line up to its newline
+    std::string inBuf;         // Partial line
+    std::string outBuf;        // Unsent replies
+} cmdClientT;
+
+// A complete command line received this frame
+typedef struct
+{
+    uint64_t clientId;
+    uint32_t offset;           // Into the frame's request text
+    uint32_t length;
+} cmdRequestT;
+
+// Single threaded, epoll driven line protocol server. Every line is one
+// command; replies are queued per client and flushed without blocking.
+class commandServer
+{
+private:
+    int epollFd;
+    int unixFd;
+    int tcpFd;
+    std::string unixPath;
+    std::vector<cmdClientT> clients;           // Indexed by fd
+    uint32_t nextGeneration;
+    std::string requestText;                   // Lines gathered this frame
+    std::vector<cmdRequestT> requests;
+    std::vector<char> readBuf;
+    epoll_event events[CMD_MAX_EVENTS];
+
+    bool ensureEpoll();
+    bool addListener(int fd);
+    void acceptClients(int listenFd);
+    void readClient(cmdClientT& client);
+    void flushClient(cmdClientT& client);
+    void closeClient(cmdClientT& client);
+
+public:
+    commandServer();
+    ~commandServer();
+    commandServer(const commandServer&) = delete;
+    commandServer& operator=(const commandServer&) = delete;
+
+    // Listens on a Unix domain socket (a stale socket file is replaced, a live
+    // one is left alone and the call fails)
+    bool listenUnix(const char* path);
+    // Listens on 127.0.0.1:port
+    bool listenTcp(unsigned short port);
+    // Accepts, reads and writes whatever is ready, without blocking.
+    // Complete lines become this frame's requests.
+    void pollEvents();
+    // Requests gathered by the last pollEvents
+    unsigned int getRequestCount() const;
+    std::string_view getRequest(unsigned int rIdx) const;
+    uint64_t getRequestClient(unsigned int rIdx) const;
+    // Drops the handled requests (storage is kept for the next frame)
+    void clearRequests();
+    // Queues a reply (ignored if the client has gone)
+    void reply(uint64_t clientId, std::string_view text);
+    // Descriptor that turns readable when pollEvents has work (-1 if not listening)
+    int getPollFd() const;
+    // Closes every socket
+    void closeAll();
+};
+
+// Complete lines of an input descriptor (the console), read only when poll
+// reports it ready so a partial line never blocks the caller
+class lineReader
+{
+private:
+    int fd;
+    std::string buf;
+    std::size_t start;         // First byte not handed out yet
+    bool open;
+    bool discarding;           // Dropping an overlong line up to its newline
+    std::vector<char> readBuf;
+
+    void readAvailable();
+
+public:
+    explicit lineReader(int fd);
+
+    // Next complete line (a last line without newline counts once the input closes)
+    // Output: false if no line is ready, the view is valid until the next call
+    bool nextLine(std::string_view& line);
+    // A complete line is buffered
+    bool hasLine() const;
+    // The input has not reached its end
+    bool isOpen() const;
+};
+
+// Lets a loop sleep in its window system's event wait and still answer
+// commands: a watcher thread polls the command descriptors while the loop is
+// armed and calls wake (which must be thread safe) once they turn readable.
+class commandWaker
+{
+private:
+    std::thread watcher;
+    std::mutex mtx;
+    std::condition_variable armedCv;
+    int nudgeFds[2];           // Pipe breaking the watcher's poll
+    std::vector<int> watchFds;
+    std::vector<int> closedFds;  // Hung up descriptors, left out of later arms (watcher only)
+    uint64_t armCnt;
+    bool armed;
+    bool stopping;
+    void (*wakeFn)();
+
+    void nudge();
+    void watchLoop();
+
+public:
+    commandWaker();
+    ~commandWaker();
+    commandWaker(const commandWaker&) = delete;
+    commandWaker& operator=(const commandWaker&) = delete;
+
+    // Starts the watcher thread
+    bool start(void (*wake)());
+    void stop();
+    // Watches the descriptors until disarm (wakes at most once per arm)
+    // Output: false if the watcher is not running (the caller must poll)
+    bool arm(const int* fds, unsigned int fdCnt);
+    void disarm();
+};
+
+#endif
@@ -0,0 +1,113 @@
+/*
+Objective:
+Engine pipe benchmark (separate executable, not linked into the viewer)
+Description :
+    Checks the UCI info line parsing of engineStats on fixed lines, then plays
+    engine requests the way the viewer's move command does (the whole game is
+    sent every time) and prints the latency, first info, nps and depth
+    statistics the viewer exports. Exits with 1 if a check fails or the engine
+    does not answer.
+
+    Build   : g++ -O2 -std=c++17 engine_bench.cpp engine_stats.cpp uci_engine.cpp -o engine_bench
+    Usage   : engine_bench [engine path] [request count]
+    Default : engine_bench ./komodo 10
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "engine_stats.hpp"
+#include "uci_engine.hpp"
+
+// Counts a failed check
+static unsigned int check(bool ok, const char* what)
+{
+    if (!ok)
+    {
+        std::printf("FAILED: %s\n", what);
+    }
+    return ok ? 0 : 1;
+}
+
+// Feeds fixed engine output through one request
+// Inputs: None
+// Output: failed checks
+static unsigned int checkInfoParsing()
+{
+    static const char* LINES[] =
+    {
+        "id name test",                                            // Not an info line
+        "info string depth 99 nps 1",                               // Free text
+        "info depth 7 seldepth 11 time 6 nodes 4463 nps 743828",
+        "info depth 9 time 9 nodes 8746 score cp -30 nps 874600 pv d7d5 e4d5",
+        "info depth 8 currmove e2e4 currmovenumber 1",              // Shallower than seen
+        "info time 12 nodes 10923 nps 910243",
+        "info nps",                                                 // Truncated
+    };
+    unsigned int failed = 0;
+    engineStats stats;
+
+    // Lines outside a request are ignored
+    stats.recordInfoLine("info depth 30 nps 5");
+    stats.beginRequest();
+    for (const char* line : LINES)
+    {
+        stats.recordInfoLine(line);
+    }
+    stats.endRequest(true);
+    failed += check(stats.getFirstInfoUs().getCount() == 1, "first info recorded once");
+    failed += check(stats.getDepth().getCount() == 1 && stats.getDepth().getMax() == 9, "deepest depth is 9");
+    failed += check(stats.getNps().getCount() == 1 && stats.getNps().getMax() == 910243, "last nps is 910243");
+    failed += check(stats.getRoundTripUs().getCount() == 1, "round trip recorded");
+
+    // A request without info lines adds no depth or nps sample
+    stats.beginRequest();
+    stats.recordInfoLine("bestmove e7e5");
+    stats.endRequest(true);
+    failed += check(stats.getDepth().getCount() == 1 && stats.getFirstInfoUs().getCount() == 1,
+                    "no samples without info lines");
+    // Failed requests only count as failures
+    stats.beginRequest();
+    stats.recordInfoLine("info depth 3 nps 10");
+    stats.endRequest(false);
+    failed += check(stats.getDepth().getCount() == 1 && stats.getRoundTripUs().getCount() == 2,
+                    "failed requests add no latency sample");
+    return failed;
+}
+
+int main(int argc, char* argv[])
+{
+    const char* enginePath = (argc > 1) ? argv[1] : UCI_ENGINE_PATH;
+    unsigned int requestCnt = (argc > 2) ? static_cast<unsigned int>(std::strtoul(argv[2], nullptr, 10)) : 10;
+
+    unsigned int failed = checkInfoParsing();
+    std::printf("Info line checks: %s\n", failed == 0 ? "passed" : "FAILED");
+
+    uciEngine engine;
+    if (!engine.start(enginePath))
+    {
+        return 1;
+    }
+    // The engine plays both sides, the game grows by one ply per request
+    engineStats stats;
+    std::string moves;
+    std::string bestMove;
+    for (unsigned int r = 0; r < requestCnt; r++)
+    {
+        stats.beginRequest();
+        bool ok = engine.requestMove(moves, bestMove, stats) && bestMove.size() >= 4 && bestMove != "(none)";
+        stats.endRequest(ok);
+        if (!ok)
+        {
+            std::printf("Request %u failed\n", r + 1);
+            failed++;
+            break;
+        }
+        moves += ' ';
+        moves += bestMove;
+    }
+    std::printf("Game:%s\n", moves.c_str());
+    stats.print(std::cout);
+    return (failed == 0) ? 0 : 1;
+}
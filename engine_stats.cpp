@@ -0,0 +1,315 @@
+#include "engine_stats.hpp"
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+unsigned int logHistogram::bucketOf(uint64_t value)
+{
+    const uint64_t sub = 1ULL << LOG_HIST_SUB_BITS;
+    if (value < sub)
+    {
+        return static_cast<unsigned int>(value);
+    }
+    unsigned int msb = 63 - __builtin_clzll(value);
+    unsigned int shift = msb - LOG_HIST_SUB_BITS;
+    return ((shift + 1) << LOG_HIST_SUB_BITS) + static_cast<unsigned int>((value >> shift) & (sub - 1));
+}
+
+uint64_t logHistogram::bucketLow(unsigned int bucket)
+{
+    const uint64_t sub = 1ULL << LOG_HIST_SUB_BITS;
+    if (bucket < sub)
+    {
+        return bucket;
+    }
+    unsigned int group = bucket >> LOG_HIST_SUB_BITS;
+    return (sub + (bucket & (sub - 1))) << (group - 1);
+}
+
+uint64_t logHistogram::bucketHigh(unsigned int bucket)
+{
+    if (bucket < (1u << LOG_HIST_SUB_BITS))
+    {
+        return bucket;
+    }
+    unsigned int group = bucket >> LOG_HIST_SUB_BITS;
+    return bucketLow(bucket) + ((1ULL << (group - 1)) - 1);
+}
+
+logHistogram::logHistogram()
+{
+    for (auto& c : counts)
+    {
+        c = 0;
+    }
+    count = 0;
+    sum = 0;
+    min = 0;
+    max = 0;
+}
+
+void logHistogram::record(uint64_t value)
+{
+    counts[bucketOf(value)]++;
+    min = (count == 0 || value < min) ? value : min;
+    max = (value > max) ? value : max;
+    count++;
+    sum += value;
+}
+
+uint64_t logHistogram::quantile(double q) const
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+    // Rank of the requested sample (1 based)
+    uint64_t rank = static_cast<uint64_t>(q * count + 0.5);
+    rank = (rank < 1) ? 1 : (rank > count ? count : rank);
+
+    uint64_t seen = 0;
+    for (unsigned int b = 0; b < LOG_HIST_BUCKETS; b++)
+    {
+        seen += counts[b];
+        if (seen >= rank)
+        {
+            uint64_t high = bucketHigh(b);
+            return (high > max) ? max : high;
+        }
+    }
+    return max;
+}
+
+uint64_t logHistogram::getCount() const
+{
+    return count;
+}
+
+uint64_t logHistogram::getSum() const
+{
+    return sum;
+}
+
+uint64_t logHistogram::getMin() const
+{
+    return min;
+}
+
+uint64_t logHistogram::getMax() const
+{
+    return max;
+}
+
+engineStats::engineStats()
+{
+    requests = 0;
+    stalls = 0;
+    failures = 0;
+    inFlight = false;
+    sawInfo = false;
+    requestNps = 0;
+    requestDepth = 0;
+    lastRoundTripUs = 0;
+}
+
+void engineStats::beginRequest()
+{
+    inFlight = true;
+    sawInfo = false;
+    requestNps = 0;
+    requestDepth = 0;
+    requestStart = clockT::now();
+}
+
+// Reads the integer following a UCI info keyword ("depth 18", "nps 1200000")
+static bool infoValue(std::string_view line, std::string_view key, uint64_t& value)
+{
+    std::size_t pos = 0;
+    while ((pos = line.find(key, pos)) != std::string_view::npos)
+    {
+        std::size_t end = pos + key.size();
+        bool wordStart = (pos == 0 || line[pos - 1] == ' ');
+        if (wordStart && end < line.size() && line[end] == ' ')
+        {
+            const char* first = line.data() + end + 1;
+            const char* last = line.data() + line.size();
+            return std::from_chars(first, last, value).ec == std::errc();
+        }
+        pos = end;
+    }
+    return false;
+}
+
+void engineStats::recordInfoLine(std::string_view line)
+{
+    // "info string" carries free text, not search values
+    if (!inFlight || line.compare(0, 5, "info ") != 0 || line.compare(0, 12, "info string ") == 0)
+    {
+        return;
+    }
+    if (!sawInfo)
+    {
+        sawInfo = true;
+        firstInfoUs.record(std::chrono::duration_cast<std::chrono::microseconds>(
+            clockT::now() - requestStart).count());
+    }
+    uint64_t value;
+    if (infoValue(line, "depth", value) && value > requestDepth)
+    {
+        requestDepth = value;
+    }
+    if (infoValue(line, "nps", value))
+    {
+        requestNps = value;
+    }
+}
+
+void engineStats::endRequest(bool ok)
+{
+    if (!inFlight)
+    {
+        return;
+    }
+    inFlight = false;
+    requests++;
+    if (!ok)
+    {
+        failures++;
+        return;
+    }
+
+    uint64_t elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        clockT::now() - requestStart).count();
+    roundTripUs.record(elapsed);
+    lastRoundTripUs = elapsed;
+    if (elapsed > ENGINE_STALL_US)
+    {
+        stalls++;
+    }
+    if (sawInfo)
+    {
+        nps.record(requestNps);
+        depth.record(requestDepth);
+    }
+}
+
+uint64_t engineStats::getLastRoundTripUs() const
+{
+    return lastRoundTripUs;
+}
+
+const logHistogram& engineStats::getRoundTripUs() const
+{
+    return roundTripUs;
+}
+
+const logHistogram& engineStats::getFirstInfoUs() const
+{
+    return firstInfoUs;
+}
+
+const logHistogram& engineStats::getNps() const
+{
+    return nps;
+}
+
+const logHistogram& engineStats::getDepth() const
+{
+    return depth;
+}
+
+void engineStats::print(std::ostream& out) const
+{
+    out << "Engine requests: " << requests << " (failures " << failures << ", stalls " << stalls << ")" << std::endl;
+    if (roundTripUs.getCount() == 0)
+    {
+        return;
+    }
+    out << "  bestmove latency ms  p50 " << roundTripUs.quantile(0.5) / 1000.0
+        << "  p90 " << roundTripUs.quantile(0.9) / 1000.0
+        << "  p99 " << roundTripUs.quantile(0.99) / 1000.0
+        << "  max " << roundTripUs.getMax() / 1000.0 << std::endl;
+    if (firstInfoUs.getCount() > 0)
+    {
+        out << "  first info ms        p50 " << firstInfoUs.quantile(0.5) / 1000.0
+            << "  p99 " << firstInfoUs.quantile(0.99) / 1000.0 << std::endl;
+    }
+    if (depth.getCount() > 0)
+    {
+        out << "  depth                p50 " << depth.quantile(0.5)
+            << "  min " << depth.getMin() << "  max " << depth.getMax() << std::endl;
+        out << "  nps                  p50 " << nps.quantile(0.5)
+            << "  min " << nps.getMin() << std::endl;
+    }
+}
+
+// Writes one histogram as a Prometheus summary
+static void writeSummary(std::ostream& out, const char* name, const char* help,
+                         const logHistogram& hist, double scale)
+{
+    static const double QUANTILES[] = {0.5, 0.9, 0.99, 0.999};
+
+    out << "# HELP " << name << " " << help << "\n";
+    out << "# TYPE " << name << " summary\n";
+    for (double q : QUANTILES)
+    {
+        // No samples yet: the quantiles are unknown, not zero
+        out << name << "{quantile=\"" << q << "\"} ";
+        if (hist.getCount() == 0)
+        {
+            out << "NaN\n";
+        }
+        else
+        {
+            out << hist.quantile(q) * scale << "\n";
+        }
+    }
+    out << name << "_sum " << hist.getSum() * scale << "\n";
+    out << name << "_count " << hist.getCount() << "\n";
+}
+
+bool engineStats::writePrometheus(const char* path) const
+{
+    // Write aside and rename so scrapers never see a partial file (the
+    // temporary name is unique, so viewers sharing a directory never mix)
+    std::string tmpPath = std::string(path) + ".XXXXXX";
+    int fd = mkstemp(tmpPath.data());
+    if (fd < 0)
+    {
+        return false;
+    }
+    // Readable by the collector, like a file written through ofstream
+    fchmod(fd, 0644);
+    close(fd);
+    bool written;
+    {
+        std::ofstream out(tmpPath, std::ios::out | std::ios::trunc);
+        out << "# HELP chess_engine_requests_total Engine move requests.\n"
+            << "# TYPE chess_engine_requests_total counter\n"
+            << "chess_engine_requests_total " << requests << "\n"
+            << "# HELP chess_engine_failures_total Engine move requests that failed.\n"
+            << "# TYPE chess_engine_failures_total counter\n"
+            << "chess_engine_failures_total " << failures << "\n"
+            << "# HELP chess_engine_stalls_total Engine move requests slower than the stall threshold.\n"
+            << "# TYPE chess_engine_stalls_total counter\n"
+            << "chess_engine_stalls_total " << stalls << "\n";
+        writeSummary(out, "chess_engine_bestmove_seconds", "Time from sending the position to reading bestmove.",
+                     roundTripUs, 1e-6);
+        writeSummary(out, "chess_engine_first_info_seconds", "Time from sending the position to the first info line.",
+                     firstInfoUs, 1e-6);
+        writeSummary(out, "chess_engine_nps", "Last nodes per second reported per search.", nps, 1.0);
+        writeSummary(out, "chess_engine_depth", "Deepest depth reported per search.", depth, 1.0);
+        out.flush();
+        written = out.good();
+    }
+    if (!written || std::rename(tmpPath.c_str(), path) != 0)
+    {
+        unlink(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,86 @@
+#ifndef ENGINE_STATS_HPP
+#define ENGINE_STATS_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+
+// Default Prometheus text file (ENGINE_METRICS_PREFIX.<pid>.prom) and refresh period
+#define ENGINE_METRICS_PREFIX "engine_metrics"
+const double ENGINE_METRICS_PERIOD = 10.0;
+// Round trips slower than this count as a stall (microseconds)
+const uint64_t ENGINE_STALL_US = 10000000;
+
+// HDR-style histogram: log2 octaves split in 2^LOG_HIST_SUB_BITS linear
+// sub-buckets, so any value is kept within 12.5% with fixed storage
+const unsigned int LOG_HIST_SUB_BITS = 3;
+const unsigned int LOG_HIST_BUCKETS = (64 - LOG_HIST_SUB_BITS + 1) << LOG_HIST_SUB_BITS;
+
+class logHistogram
+{
+private:
+    uint64_t counts[LOG_HIST_BUCKETS];
+    uint64_t count;
+    uint64_t sum;
+    uint64_t min;
+    uint64_t max;
+
+    static unsigned int bucketOf(uint64_t value);
+    static uint64_t bucketLow(unsigned int bucket);
+    static uint64_t bucketHigh(unsigned int bucket);
+
+public:
+    logHistogram();
+    void record(uint64_t value);
+    // Value at quantile q in [0, 1] (upper edge of its bucket, clamped to max)
+    uint64_t quantile(double q) const;
+    uint64_t getCount() const;
+    uint64_t getSum() const;
+    uint64_t getMin() const;
+    uint64_t getMax() const;
+};
+
+// Health metrics of the engine pipe
+class engineStats
+{
+private:
+    typedef std::chrono::steady_clock clockT;
+
+    logHistogram roundTripUs;     // Position sent to bestmove
+    logHistogram firstInfoUs;     // Position sent to the first "info" line
+    logHistogram nps;             // Last reported nodes per second
+    logHistogram depth;           // Deepest reported depth
+    uint64_t requests;
+    uint64_t stalls;
+    uint64_t failures;
+
+    // Request in flight
+    bool inFlight;
+    bool sawInfo;
+    clockT::time_point requestStart;
+    uint64_t requestNps;
+    uint64_t requestDepth;
+    uint64_t lastRoundTripUs;
+
+public:
+    engineStats();
+    // Call right before the position/go is written to the engine
+    void beginRequest();
+    // Call for every line read from the engine while a request is in flight
+    void recordInfoLine(std::string_view line);
+    // Call once bestmove was read (ok = false if the exchange failed)
+    void endRequest(bool ok);
+    // Round trip of the last successful request (microseconds)
+    uint64_t getLastRoundTripUs() const;
+    const logHistogram& getRoundTripUs() const;
+    const logHistogram& getFirstInfoUs() const;
+    const logHistogram& getNps() const;
+    const logHistogram& getDepth() const;
+    // Human readable summary
+    void print(std::ostream& out) const;
+    // Writes the metrics in Prometheus text format (atomic replace)
+    bool writePrometheus(const char* path) const;
+};
+
+#endif
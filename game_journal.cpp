@@ -0,0 +1,566 @@
+#include "game_journal.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const uint32_t JOURNAL_MAGIC = 0x4c4e4a43;       // "CJNL"
+static const uint32_t JOURNAL_INDEX_MAGIC = 0x58494a43; // "CJIX"
+static const uint32_t JOURNAL_VERSION = 2;        // 2: positions keep the side to move and en passant file
+
+static_assert(sizeof(journalHeaderT) == 16, "journal header layout");
+static_assert(sizeof(journalRecordT) == 96, "journal records are fixed size");
+static_assert(sizeof(journalIndexT) == 24, "index entries are fixed size");
+
+// Index order: game, then ply
+static bool entryLess(const journalIndexT& a, const journalIndexT& b)
+{
+    return (a.game != b.game) ? a.game < b.game : a.ply < b.ply;
+}
+
+// Writes a whole buffer, retrying short writes
+static bool writeAll(int fd, const void* data, std::size_t size)
+{
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0)
+    {
+        ssize_t n = write(fd, bytes, size);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            return false;
+        }
+        bytes += n;
+        size -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+static uint64_t wallClockUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+gameJournal::gameJournal()
+{
+    fd = -1;
+    recordCnt = 0;
+    journalMap = nullptr;
+    journalBytes = 0;
+    mappedCnt = 0;
+    indexMap = nullptr;
+    indexBytes = 0;
+    fileEntries = nullptr;
+    fileEntryCnt = 0;
+    tailSorted = true;
+    nextGame = 1;
+}
+
+gameJournal::~gameJournal()
+{
+    close();
+}
+
+bool gameJournal::open(const char* journalPath, const char* idxPath)
+{
+    close();
+    fd = ::open(journalPath, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        std::cout << "Cannot open " << journalPath << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    // One writer per journal: the game numbers, the index and the torn record
+    // repair all assume no other viewer appends (the lock goes with the fd)
+    if (flock(fd, LOCK_EX | LOCK_NB) != 0)
+    {
+        if (errno == EWOULDBLOCK)
+        {
+            std::cout << journalPath << " is in use by another viewer, games are not recorded" << std::endl;
+        }
+        else
+        {
+            std::cout << "Cannot lock " << journalPath << ": " << std::strerror(errno) << std::endl;
+        }
+        close();
+        return false;
+    }
+    indexPath = idxPath;
+
+    struct stat st;
+    journalHeaderT header;
+    if (fstat(fd, &st) != 0)
+    {
+        close();
+        return false;
+    }
+    if (st.st_size == 0)
+    { // New journal
+        header = {JOURNAL_MAGIC, JOURNAL_VERSION, sizeof(journalRecordT), 0};
+        if (write(fd, &header, sizeof(header)) != static_cast<ssize_t>(sizeof(header)))
+        {
+            close();
+            return false;
+        }
+        st.st_size = sizeof(header);
+    }
+    else if (pread(fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)) ||
+             header.magic != JOURNAL_MAGIC || header.version != JOURNAL_VERSION ||
+             header.recordSize != sizeof(journalRecordT))
+    {
+        std::cout << journalPath << " is not a game journal of this version" << std::endl;
+        close();
+        return false;
+    }
+
+    // Drop a record torn by a crash
+    recordCnt = (st.st_size - sizeof(header)) / sizeof(journalRecordT);
+    off_t whole = sizeof(header) + recordCnt * sizeof(journalRecordT);
+    if (st.st_size != whole && ftruncate(fd, whole) != 0)
+    {
+        close();
+        return false;
+    }
+
+    if (!mapIndex() && (!rebuildIndex() || !mapIndex()))
+    {
+        std::cout << "Cannot build " << indexPath << std::endl;
+        close();
+        return false;
+    }
+    nextGame = (fileEntryCnt > 0) ? fileEntries[fileEntryCnt - 1].game + 1 : 1;
+    return true;
+}
+
+void gameJournal::close()
+{
+    if (fd >= 0 && !tailEntries.empty())
+    {
+        // This session's games all come after the indexed ones
+        if (!tailSorted)
+        {
+            std::sort(tailEntries.begin(), tailEntries.end(), entryLess);
+        }
+        std::vector<journalIndexT> entries(fileEntries, fileEntries + fileEntryCnt);
+        entries.insert(entries.end(), tailEntries.begin(), tailEntries.end());
+        writeIndex(entries);
+    }
+    unmapIndex();
+    if (journalMap != nullptr)
+    {
+        munmap(journalMap, journalBytes);
+        journalMap = nullptr;
+        journalBytes = 0;
+        mappedCnt = 0;
+    }
+    if (fd >= 0)
+    {
+        ::close(fd);
+        fd = -1;
+    }
+    recordCnt = 0;
+    tailEntries.clear();
+    tailSorted = true;
+    boardGames.clear();
+}
+
+bool gameJournal::isOpen() const
+{
+    return fd >= 0;
+}
+
+bool gameJournal::appendRecord(const journalRecordT& record, uint64_t& rIdx)
+{
+    // O_APPEND keeps every record at the end of the file, and the offset it
+    // leaves tells where this one landed
+    ssize_t written = write(fd, &record, sizeof(record));
+    off_t end = lseek(fd, 0, SEEK_CUR);
+    if (written != static_cast<ssize_t>(sizeof(record)) || end < 0)
+    { // Cut a short write so the next record stays aligned
+        if (written > 0 && end >= 0 && ftruncate(fd, end - written) != 0)
+        {
+            std::cout << "Game journal is damaged past record " << recordCnt << std::endl;
+        }
+        return false;
+    }
+    uint64_t endCnt = (end - sizeof(journalHeaderT)) / sizeof(journalRecordT);
+    rIdx = endCnt - 1;
+    recordCnt = endCnt;
+    return true;
+}
+
+void gameJournal::addEntry(const journalIndexT& entry)
+{
+    // Boards take turns, so the games interleave
+    if (!tailEntries.empty() && entryLess(entry, tailEntries.back()))
+    {
+        tailSorted = false;
+    }
+    tailEntries.push_back(entry);
+}
+
+const journalRecordT* gameJournal::getRecord(uint64_t rIdx)
+{
+    if (rIdx >= recordCnt)
+    {
+        return nullptr;
+    }
+    if (rIdx >= mappedCnt)
+    {
+        if (journalMap != nullptr)
+        {
+            munmap(journalMap, journalBytes);
+            journalMap = nullptr;
+            mappedCnt = 0;
+        }
+        std::size_t bytes = sizeof(journalHeaderT) + recordCnt * sizeof(journalRecordT);
+        void* mapping = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+        if (mapping == MAP_FAILED)
+        {
+            return nullptr;
+        }
+        journalMap = mapping;
+        journalBytes = bytes;
+        mappedCnt = recordCnt;
+    }
+    const char* base = static_cast<const char*>(journalMap) + sizeof(journalHeaderT);
+    return reinterpret_cast<const journalRecordT*>(base) + rIdx;
+}
+
+void gameJournal::entryRange(uint32_t game, const journalIndexT*& first, const journalIndexT*& last)
+{
+    if (fileEntryCnt > 0 && game <= fileEntries[fileEntryCnt - 1].game)
+    {
+        first = fileEntries;
+        last = fileEntries + fileEntryCnt;
+    }
+    else
+    {
+        if (!tailSorted)
+        {
+            std::sort(tailEntries.begin(), tailEntries.end(), entryLess);
+            tailSorted = true;
+        }
+        first = tailEntries.data();
+        last = first + tailEntries.size();
+    }
+}
+
+const journalIndexT* gameJournal::findEntry(uint32_t game, uint32_t ply)
+{
+    const journalIndexT* first;
+    const journalIndexT* last;
+    entryRange(game, first, last);
+    journalIndexT key = {game, ply, 0, 0};
+    const journalIndexT* entry = std::lower_bound(first, last, key, entryLess);
+    if (entry == last || entry->game != game || entry->ply != ply)
+    {
+        return nullptr;
+    }
+    return entry;
+}
+
+bool gameJournal::mapIndex()
+{
+    unmapIndex();
+    int idxFd = ::open(indexPath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (idxFd < 0)
+    {
+        return false;
+    }
+    struct stat st;
+    journalIndexHeaderT header;
+    if (fstat(idxFd, &st) != 0 ||
+        pread(idxFd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)) ||
+        header.magic != JOURNAL_INDEX_MAGIC || header.version != JOURNAL_VERSION ||
+        header.journalRecords != recordCnt ||
+        static_cast<uint64_t>(st.st_size) != sizeof(header) + header.entryCount * sizeof(journalIndexT))
+    { // Missing, foreign or stale (the journal grew without it)
+        ::close(idxFd);
+        return false;
+    }
+
+    void* mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, idxFd, 0);
+    ::close(idxFd);
+    if (mapping == MAP_FAILED)
+    {
+        return false;
+    }
+    indexMap = mapping;
+    indexBytes = st.st_size;
+    fileEntries = reinterpret_cast<const journalIndexT*>(static_cast<const char*>(mapping) + sizeof(header));
+    fileEntryCnt = header.entryCount;
+    return true;
+}
+
+void gameJournal::unmapIndex()
+{
+    if (indexMap != nullptr)
+    {
+        munmap(indexMap, indexBytes);
+    }
+    indexMap = nullptr;
+    indexBytes = 0;
+    fileEntries = nullptr;
+    fileEntryCnt = 0;
+}
+
+bool gameJournal::rebuildIndex()
+{
+    // Per game: position of its last entry and its latest snapshot
+    typedef struct
+    {
+        std::size_t lastEntry;
+        uint64_t snapshot;
+    } gameScanT;
+    std::unordered_map<uint32_t, gameScanT> games;
+    std::vector<journalIndexT> entries;
+    entries.reserve(recordCnt);
+
+    for (uint64_t rIdx = 0; rIdx < recordCnt; rIdx++)
+    {
+        const journalRecordT* record = getRecord(rIdx);
+        if (record == nullptr)
+        {
+            return false;
+        }
+        if (record->kind == JOURNAL_GAME_START)
+        {
+            games[record->game] = {entries.size(), rIdx};
+            entries.push_back({record->game, 0, rIdx, rIdx});
+            continue;
+        }
+        auto git = games.find(record->game);
+        if (git == games.end())
+        {
+            continue;
+        }
+        // Records of a game follow each other ply by ply, anything else is skipped
+        uint32_t lastPly = entries[git->second.lastEntry].ply;
+        if (record->kind == JOURNAL_SNAPSHOT && record->ply == lastPly)
+        {
+            git->second.snapshot = rIdx;
+            entries[git->second.lastEntry].snapshot = rIdx;
+        }
+        else if ((record->kind == JOURNAL_PLAYER_MOVE || record->kind == JOURNAL_ENGINE_MOVE) &&
+                 record->ply == lastPly + 1)
+        {
+            git->second.lastEntry = entries.size();
+            entries.push_back({record->game, record->ply, rIdx, git->second.snapshot});
+        }
+    }
+
+    std::sort(entries.begin(), entries.end(), entryLess);
+    return writeIndex(entries);
+}
+
+bool gameJournal::writeIndex(const std::vector<journalIndexT>& entries) const
+{
+    journalIndexHeaderT header = {JOURNAL_INDEX_MAGIC, JOURNAL_VERSION, recordCnt, entries.size()};
+
+    // Write aside and rename so a reader never maps a partial index (the
+    // temporary name is unique, so two viewers closing at once never share it)
+    std::string tmpPath = indexPath + ".XXXXXX";
+    int tmpFd = mkstemp(tmpPath.data());
+    if (tmpFd < 0)
+    {
+        return false;
+    }
+    // Same permissions as the journal
+    bool written = fchmod(tmpFd, 0644) == 0 &&
+                   writeAll(tmpFd, &header, sizeof(header)) &&
+                   writeAll(tmpFd, entries.data(), entries.size() * sizeof(journalIndexT));
+    written = (::close(tmpFd) == 0) && written;
+    if (!written || std::rename(tmpPath.c_str(), indexPath.c_str()) != 0)
+    {
+        unlink(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+void gameJournal::startGames(unsigned int boardCnt)
+{
+    boardGames.assign(boardCnt, {0, 0, 0, false});
+    if (fd < 0)
+    {
+        return;
+    }
+    uint64_t timeUs = wallClockUs();
+    for (unsigned int b = 0; b < boardCnt; b++)
+    {
+        journalRecordT record = {};
+        record.kind = JOURNAL_GAME_START;
+        record.board = static_cast<uint16_t>(b);
+        record.game = nextGame;
+        record.timeUs = timeUs;
+        uint64_t rIdx;
+        if (!appendRecord(record, rIdx))
+        {
+            return;
+        }
+        boardGames[b] = {nextGame, 0, rIdx, true};
+        addEntry({nextGame, 0, rIdx, rIdx});
+        nextGame++;
+    }
+}
+
+void gameJournal::recordMove(unsigned int board, uint8_t kind, std::string_view move, uint32_t engineUs,
+                             const chessBoard& position)
+{
+    if (fd < 0 || board >= boardGames.size() || !boardGames[board].recording)
+    {
+        return;
+    }
+    boardGameT& bGame = boardGames[board];
+
+    journalRecordT record = {};
+    record.kind = kind;
+    record.board = static_cast<uint16_t>(board);
+    record.game = bGame.game;
+    record.ply = bGame.ply + 1;
+    record.engineUs = engineUs;
+    record.timeUs = wallClockUs();
+    std::memcpy(record.move, move.data(), std::min(move.size(), sizeof(record.move)));
+    uint64_t rIdx;
+    if (!appendRecord(record, rIdx))
+    { // Keep the game consistent with what reached the disk
+        bGame.recording = false;
+        return;
+    }
+    bGame.ply++;
+
+    // Periodic snapshot, right behind its move
+    if (bGame.ply % JOURNAL_SNAPSHOT_PLIES == 0)
+    {
+        journalRecordT snapshot = record;
+        snapshot.kind = JOURNAL_SNAPSHOT;
+        snapshot.engineUs = 0;
+        uint64_t sIdx;
+        if (position.saveState(snapshot.state) && appendRecord(snapshot, sIdx))
+        {
+            bGame.snapshot = sIdx;
+        }
+    }
+    addEntry({bGame.game, bGame.ply, rIdx, bGame.snapshot});
+}
+
+void gameJournal::reviewBoard(unsigned int board, uint32_t game, uint32_t ply)
+{
+    if (board < boardGames.size())
+    {
+        boardGames[board] = {game, ply, 0, false};
+    }
+}
+
+bool gameJournal::getBoardGame(unsigned int board, uint32_t& game, uint32_t& ply) const
+{
+    if (board >= boardGames.size() || boardGames[board].game == 0)
+    {
+        return false;
+    }
+    game = boardGames[board].game;
+    ply = boardGames[board].ply;
+    return true;
+}
+
+bool gameJournal::isRecording(unsigned int board) const
+{
+    return board < boardGames.size() && boardGames[board].recording;
+}
+
+bool gameJournal::getLastPly(uint32_t game, uint32_t& ply)
+{
+    const journalIndexT* first;
+    const journalIndexT* last;
+    entryRange(game, first, last);
+    // Entry before the next game's first one
+    journalIndexT key = {game + 1, 0, 0, 0};
+    const journalIndexT* next = std::lower_bound(first, last, key, entryLess);
+    if (next == first || next[-1].game != game)
+    {
+        return false;
+    }
+    ply = next[-1].ply;
+    return true;
+}
+
+bool gameJournal::getMove(uint32_t game, uint32_t ply, std::string& move)
+{
+    const journalIndexT* entry = (ply > 0) ? findEntry(game, ply) : nullptr;
+    const journalRecordT* record = (entry != nullptr) ? getRecord(entry->record) : nullptr;
+    if (record == nullptr)
+    {
+        return false;
+    }
+    move.assign(record->move, strnlen(record->move, sizeof(record->move)));
+    return true;
+}
+
+bool gameJournal::seek(uint32_t game, uint32_t ply, chessBoard& position)
+{
+    const journalIndexT* entry = findEntry(game, ply);
+    const journalRecordT* base = (entry != nullptr) ? getRecord(entry->snapshot) : nullptr;
+    if (base == nullptr || base->game != game || base->ply > ply)
+    {
+        return false;
+    }
+
+    // Start from the latest snapshot (or the start position)
+    uint32_t basePly = 0;
+    if (base->kind == JOURNAL_SNAPSHOT)
+    {
+        if (!position.loadState(base->state))
+        {
+            return false;
+        }
+        basePly = base->ply;
+    }
+    else
+    {
+        position.resetPieces();
+    }
+
+    // Replay the few moves since, their entries sit right before this one
+    const journalIndexT* first;
+    const journalIndexT* last;
+    entryRange(game, first, last);
+    if (entry - first < static_cast<std::ptrdiff_t>(ply - basePly))
+    {
+        return false;
+    }
+    moveResultT result;
+    for (uint32_t p = basePly + 1; p <= ply; p++)
+    {
+        const journalIndexT& pEntry = entry[static_cast<std::ptrdiff_t>(p) - ply];
+        const journalRecordT* record = getRecord(pEntry.record);
+        if (pEntry.game != game || pEntry.ply != p || record == nullptr ||
+            !position.applyMove(std::string_view(record->move, strnlen(record->move, sizeof(record->move))), result))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint32_t gameJournal::getGameCount() const
+{
+    return nextGame - 1;
+}
+
+uint64_t gameJournal::getRecordCount() const
+{
+    return recordCnt;
+}
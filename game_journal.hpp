@@ -0,0 +1,148 @@
+#ifndef GAME_JOURNAL_HPP
+#define GAME_JOURNAL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "chessBoard.h"
+
+// Journal and its seek index (relative to the working directory)
+#define GAME_JOURNAL_FILE "game_journal.bin"
+#define GAME_JOURNAL_INDEX_FILE "game_journal.idx"
+// Plies between full position snapshots (bounds the moves replayed by a seek)
+const uint32_t JOURNAL_SNAPSHOT_PLIES = 16;
+
+// Record kinds
+const uint8_t JOURNAL_GAME_START = 1;      // Board reset to the start position (ply 0)
+const uint8_t JOURNAL_PLAYER_MOVE = 2;
+const uint8_t JOURNAL_ENGINE_MOVE = 3;
+const uint8_t JOURNAL_SNAPSHOT = 4;        // Position right after the same ply
+
+// Journal file header
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t recordSize;
+    uint32_t reserved;
+} journalHeaderT;
+
+// Fixed size journal record
+typedef struct
+{
+    uint8_t kind;
+    uint8_t reserved;
+    uint16_t board;            // Dashboard board the game is played on
+    uint32_t game;             // Numbered from 1 across sessions
+    uint32_t ply;              // Ply reached (0 for the start record)
+    uint32_t engineUs;         // Engine round trip (engine moves)
+    uint64_t timeUs;           // Wall clock, microseconds since the epoch
+    union
+    {
+        char move[8];          // Long algebraic notation, zero padded
+        boardStateT state;     // Snapshot position
+    };
+} journalRecordT;
+
+// Index file header
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t journalRecords;   // Records covered (the index is stale if the journal has more)
+    uint64_t entryCount;
+} journalIndexHeaderT;
+
+// One ply of one game, sorted by (game, ply)
+typedef struct
+{
+    uint32_t game;
+    uint32_t ply;
+    uint64_t record;           // Record reaching the ply
+    uint64_t snapshot;         // Latest start or snapshot record at or before the ply
+} journalIndexT;
+
+// Append-only record of the games played on the dashboard boards. Every
+// applied move is one fixed size record and the position is snapshotted every
+// JOURNAL_SNAPSHOT_PLIES plies, so a position is rebuilt from a binary search
+// in the memory mapped index plus a few moves.
+class gameJournal
+{
+private:
+    // Game followed by a dashboard board
+    typedef struct
+    {
+        uint32_t game;
+        uint32_t ply;
+        uint64_t snapshot;     // Latest start or snapshot record of the game
+        bool recording;        // False once the board is used for review
+    } boardGameT;
+
+    int fd;
+    uint64_t recordCnt;
+    std::string indexPath;
+
+    // Read only mapping of the journal (remapped when records are past its end)
+    void* journalMap;
+    std::size_t journalBytes;
+    uint64_t mappedCnt;
+
+    // Index of the earlier sessions' games (memory mapped)
+    void* indexMap;
+    std::size_t indexBytes;
+    const journalIndexT* fileEntries;
+    uint64_t fileEntryCnt;
+    // Entries of this session's games (all newer, sorted on demand)
+    std::vector<journalIndexT> tailEntries;
+    bool tailSorted;
+
+    std::vector<boardGameT> boardGames;
+    uint32_t nextGame;
+
+    // Appends a record, rIdx is where it landed
+    bool appendRecord(const journalRecordT& record, uint64_t& rIdx);
+    void addEntry(const journalIndexT& entry);
+    const journalRecordT* getRecord(uint64_t rIdx);
+    void entryRange(uint32_t game, const journalIndexT*& first, const journalIndexT*& last);
+    const journalIndexT* findEntry(uint32_t game, uint32_t ply);
+    bool mapIndex();
+    void unmapIndex();
+    bool rebuildIndex();
+    bool writeIndex(const std::vector<journalIndexT>& entries) const;
+
+public:
+    gameJournal();
+    ~gameJournal();
+    gameJournal(const gameJournal&) = delete;
+    gameJournal& operator=(const gameJournal&) = delete;
+
+    // Opens (or creates) the journal, a missing or stale index is rebuilt
+    // (fails if another viewer has it open: one writer per journal)
+    bool open(const char* journalPath, const char* idxPath);
+    // Writes the index for this session's games and closes the files
+    void close();
+    bool isOpen() const;
+    // Starts a new game on every board (all at the start position)
+    void startGames(unsigned int boardCnt);
+    // Records a move applied to a board (position is the board after the move)
+    void recordMove(unsigned int board, uint8_t kind, std::string_view move, uint32_t engineUs,
+                    const chessBoard& position);
+    // Marks a board as showing a journal position (its moves are no longer recorded)
+    void reviewBoard(unsigned int board, uint32_t game, uint32_t ply);
+    // Game and ply shown on a board
+    bool getBoardGame(unsigned int board, uint32_t& game, uint32_t& ply) const;
+    bool isRecording(unsigned int board) const;
+    // Last ply recorded for a game
+    bool getLastPly(uint32_t game, uint32_t& ply);
+    // Move reaching a ply (ply >= 1)
+    bool getMove(uint32_t game, uint32_t ply, std::string& move);
+    // Rebuilds the position of a game at a ply
+    // (position must be set up from the same components, it is undefined on failure)
+    bool seek(uint32_t game, uint32_t ply, chessBoard& position);
+    uint32_t getGameCount() const;
+    uint64_t getRecordCount() const;
+};
+
+#endif
@@ -1,15 +1,105 @@
 #include "helper_functions.hpp"
+#include <charconv>
+#include <cmath>
 
 
-std::vector<std::string> parseInputCmd(std::string str)
+bool tokenizeInputCmd(std::string_view line, cmdTokensT& cmd)
 {
-    std::stringstream ss(str);
-    std::string word;
-    std::vector<std::string> words;
+    std::size_t pos = 0;
 
-    while (ss >> word) {
-        words.push_back(word);
+    cmd.count = 0;
+    while (true)
+    {
+        pos = line.find_first_not_of(" \t\r\n", pos);
+        if (pos == std::string_view::npos)
+        {
+            return true;
+        }
+        if (cmd.count == MAX_CMD_TOKENS)
+        {
+            return false;
+        }
+        std::size_t end = line.find_first_of(" \t\r\n", pos);
+        if (end == std::string_view::npos)
+        {
+            end = line.size();
+        }
+        cmd.tokens[cmd.count++] = line.substr(pos, end - pos);
+        pos = end;
     }
+}
 
-    return words;
+bool parseFloat(std::string_view token, float& value)
+{
+    const char* last = token.data() + token.size();
+    float parsed = 0.f;
+    auto result = std::from_chars(token.data(), last, parsed);
+
+    if (result.ec != std::errc() || result.ptr != last)
+    {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+bool parseUInt(std::string_view token, unsigned int& value)
+{
+    const char* last = token.data() + token.size();
+    unsigned int parsed = 0;
+    auto result = std::from_chars(token.data(), last, parsed);
+
+    if (result.ec != std::errc() || result.ptr != last)
+    {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+bool parseInt(std::string_view token, int& value)
+{
+    const char* last = token.data() + token.size();
+    int parsed = 0;
+    auto result = std::from_chars(token.data(), last, parsed);
+
+    if (result.ec != std::errc() || result.ptr != last)
+    {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+const cmdEntryT* findCommand(const cmdEntryT* table, std::size_t count, std::string_view verb)
+{
+    std::size_t lo = 0;
+    std::size_t hi = count;
+
+    while (lo < hi)
+    {
+        std::size_t mid = (lo + hi) / 2;
+        int order = verb.compare(table[mid].verb);
+        if (order == 0)
+        {
+            return &table[mid];
+        }
+        if (order < 0)
+        {
+            hi = mid;
+        }
+        else
+        {
+            lo = mid + 1;
+        }
+    }
+    return nullptr;
+}
+
+glm::vec3 sphericalToCartesian(float theta, float phi, float r)
+{
+    float posX = r * sin(glm::radians(theta)) * cos(glm::radians(phi));
+    float posY = r * sin(glm::radians(theta)) * sin(glm::radians(phi));
+    float posZ = r * cos(glm::radians(theta));
+    return glm::vec3(posX, posY, posZ);
 }
\ No newline at end of file
@@ -1,10 +1,47 @@
 #ifndef HELPER_FUNCTIONS_HPP
 #define HELPER_FUNCTIONS_HPP
 
-#include <sstream>
-#include <vector>
+#include <cstddef>
 #include <string>
+#include <string_view>
+#include <glm/glm.hpp>
 
-std::vector<std::string> parseInputCmd(std::string);
+// Max tokens in a command line (verb plus arguments)
+const unsigned int MAX_CMD_TOKENS = 512;
+
+// Tokens of a command line, viewing into the caller's line buffer
+typedef struct
+{
+    std::string_view tokens[MAX_CMD_TOKENS];
+    unsigned int count;
+} cmdTokensT;
+
+// Command verb to handler mapping
+typedef bool (*cmdHandlerT)(const cmdTokensT& cmd);
+typedef struct
+{
+    std::string_view verb;
+    cmdHandlerT handler;
+} cmdEntryT;
+
+bool tokenizeInputCmd(std::string_view line, cmdTokensT& cmd);
+bool parseFloat(std::string_view token, float& value);
+bool parseUInt(std::string_view token, unsigned int& value);
+bool parseInt(std::string_view token, int& value);
+const cmdEntryT* findCommand(const cmdEntryT* table, std::size_t count, std::string_view verb);
+glm::vec3 sphericalToCartesian(float theta, float phi, float r);
+
+// Checks a command table is sorted by verb (binary search precondition)
+constexpr bool isCmdTableSorted(const cmdEntryT* table, std::size_t count)
+{
+    for (std::size_t i = 1; i < count; i++)
+    {
+        if (!(table[i - 1].verb < table[i].verb))
+        {
+            return false;
+        }
+    }
+    return true;
+}
 
 #endif
\ No newline at end of file
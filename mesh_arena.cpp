@@ -0,0 +1,62 @@
+#include "mesh_arena.hpp"
+#include <new>
+
+meshArena::meshArena()
+{
+    block = nullptr;
+    capacity = 0;
+    used = 0;
+}
+
+meshArena::~meshArena()
+{
+    release();
+}
+
+bool meshArena::reserve(std::size_t bytes)
+{
+    release();
+    if (bytes == 0)
+    {
+        return true;
+    }
+    block = static_cast<unsigned char*>(::operator new(bytes, std::align_val_t(MESH_ARENA_ALIGN), std::nothrow));
+    if (block == nullptr)
+    {
+        return false;
+    }
+    capacity = bytes;
+    return true;
+}
+
+void* meshArena::allocateBytes(std::size_t bytes)
+{
+    if (bytes > capacity - used)
+    {
+        return nullptr;
+    }
+    void* bytesAt = block + used;
+    used += bytes;
+    return bytesAt;
+}
+
+void meshArena::release()
+{
+    if (block != nullptr)
+    {
+        ::operator delete(block, std::align_val_t(MESH_ARENA_ALIGN));
+    }
+    block = nullptr;
+    capacity = 0;
+    used = 0;
+}
+
+std::size_t meshArena::getCapacity() const
+{
+    return capacity;
+}
+
+std::size_t meshArena::getUsed() const
+{
+    return used;
+}
@@ -0,0 +1,77 @@
+#ifndef MESH_ARENA_HPP
+#define MESH_ARENA_HPP
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+// Alignment of every array carved out of an arena (fits the SIMD kernels)
+const std::size_t MESH_ARENA_ALIGN = 32;
+
+// Non owning view of an array (mesh data in an arena, or a vector)
+template <typename T>
+class meshSpan
+{
+private:
+    T* first;
+    std::size_t count;
+
+public:
+    meshSpan() : first(nullptr), count(0) {}
+    meshSpan(T* data, std::size_t count) : first(data), count(count) {}
+    // Views of the same array with a const element type
+    template <typename U, typename = std::enable_if_t<std::is_convertible<U (*)[], T (*)[]>::value>>
+    meshSpan(const meshSpan<U>& other) : first(other.data()), count(other.size()) {}
+    // Views of contiguous containers (vectors)
+    template <typename C, typename = std::enable_if_t<
+                              std::is_convertible<decltype(std::declval<C&>().data()), T*>::value>>
+    meshSpan(C& container) : first(container.data()), count(container.size()) {}
+
+    T* data() const { return first; }
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    T& operator[](std::size_t i) const { return first[i]; }
+    T* begin() const { return first; }
+    T* end() const { return first + count; }
+};
+
+// Bump allocator over one block: the arrays of many meshes are carved out of
+// a single allocation and all released at once (nothing is freed on its own)
+class meshArena
+{
+private:
+    unsigned char* block;
+    std::size_t capacity;
+    std::size_t used;
+
+    void* allocateBytes(std::size_t bytes);
+
+public:
+    meshArena();
+    ~meshArena();
+    meshArena(const meshArena&) = delete;
+    meshArena& operator=(const meshArena&) = delete;
+
+    // Bytes an array of count items takes in the arena
+    template <typename T>
+    static std::size_t getFootprint(std::size_t count)
+    {
+        return (count * sizeof(T) + MESH_ARENA_ALIGN - 1) & ~(MESH_ARENA_ALIGN - 1);
+    }
+    // Allocates the block (views into a previous block become invalid)
+    bool reserve(std::size_t bytes);
+    // Carves an array out of the block, uninitialized (empty if it does not fit)
+    template <typename T>
+    meshSpan<T> allocate(std::size_t count)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "Arena arrays hold plain data");
+        void* bytes = allocateBytes(getFootprint<T>(count));
+        return bytes ? meshSpan<T>(static_cast<T*>(bytes), count) : meshSpan<T>();
+    }
+    // Frees the block
+    void release();
+    std::size_t getCapacity() const;
+    std::size_t getUsed() const;
+};
+
+#endif
@@ -0,0 +1,214 @@
+/*
+Objective:
+Mesh preprocessing benchmark (separate executable, not linked into the viewer)
+Description :
+    Times the load time geometry kernels of mesh_preprocess.hpp on synthetic
+    meshes: the scalar loops chessComponent used before (separate centroid and
+    bounding box passes) against the fused pass, and every kernel set the CPU
+    supports against the scalar one. Results are checked against the scalar set.
+
+    Build   : g++ -O2 -std=c++17 -pthread mesh_bench.cpp mesh_preprocess.cpp -o mesh_bench
+    Usage   : mesh_bench [vertex count...]
+    Default : mesh_bench 4096 16384 65025
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "mesh_preprocess.hpp"
+
+// Minimum time spent on each measurement (best run is reported)
+const double BENCH_MIN_MS = 200.0;
+
+// Synthetic mesh: a bumpy sphere grid with UVs, unnormalized normals and triangles
+typedef struct
+{
+    std::vector<glm::vec3> vertices;
+    std::vector<glm::vec2> uvs;
+    std::vector<glm::vec3> normals;
+    std::vector<unsigned short> indices;
+} benchMeshT;
+
+// Makes a grid mesh with about vertexCnt vertices (16 bit indices cap it at 65536)
+static benchMeshT makeMesh(unsigned int vertexCnt)
+{
+    benchMeshT mesh;
+    unsigned int side = std::max(2U, std::min(256U, static_cast<unsigned int>(std::sqrt(static_cast<double>(vertexCnt)))));
+    for (unsigned int row = 0; row < side; row++)
+    {
+        for (unsigned int col = 0; col < side; col++)
+        {
+            float u = col / static_cast<float>(side - 1);
+            float v = row / static_cast<float>(side - 1);
+            float theta = 6.2831853f * u;
+            float phi = 3.1415926f * (0.02f + 0.96f * v);
+            float r = 10.f + 0.5f * std::sin(13.f * theta) * std::sin(7.f * phi);
+            glm::vec3 dir(std::sin(phi) * std::cos(theta), std::cos(phi), std::sin(phi) * std::sin(theta));
+            mesh.vertices.push_back(dir * r + glm::vec3(3.f, 1.f, -2.f));
+            mesh.uvs.push_back(glm::vec2(u, v));
+            mesh.normals.push_back(dir * (0.5f + (row * side + col) % 7 * 0.25f));
+        }
+    }
+    for (unsigned int row = 0; row + 1 < side; row++)
+    {
+        for (unsigned int col = 0; col + 1 < side; col++)
+        {
+            unsigned short a = static_cast<unsigned short>(row * side + col);
+            unsigned short b = static_cast<unsigned short>(a + 1);
+            unsigned short c = static_cast<unsigned short>(a + side);
+            unsigned short d = static_cast<unsigned short>(c + 1);
+            mesh.indices.insert(mesh.indices.end(), {a, c, b, b, c, d});
+        }
+    }
+    return mesh;
+}
+
+// Centroid as chessComponent::getGeometricCenter computed it
+static glm::vec3 legacyCenter(const std::vector<glm::vec3>& vertices)
+{
+    glm::vec3 center = glm::vec3(0.0f);
+    for (const auto& vertex : vertices)
+    {
+        center.x += vertex.x;
+        center.y += vertex.y;
+        center.z += vertex.z;
+    }
+    return vertices.empty() ? glm::vec3(0.0f) : center / static_cast<float>(vertices.size());
+}
+
+// Bounding box as chessComponent::getBoundingBox computed it
+static void legacyBox(const std::vector<glm::vec3>& vertices, glm::vec3& bMin, glm::vec3& bMax)
+{
+    bMin = vertices.front();
+    bMax = vertices.front();
+    for (const auto& vertex : vertices)
+    {
+        bMin = glm::min(bMin, vertex);
+        bMax = glm::max(bMax, vertex);
+    }
+}
+
+// Best time of a function over BENCH_MIN_MS (milliseconds per call)
+template <typename fnT>
+static double timeBest(fnT fn)
+{
+    typedef std::chrono::steady_clock clockT;
+    double best = 1e30;
+    double total = 0.0;
+    unsigned int runs = 0;
+    while (total < BENCH_MIN_MS || runs < 3)
+    {
+        clockT::time_point start = clockT::now();
+        fn();
+        double ms = std::chrono::duration<double, std::milli>(clockT::now() - start).count();
+        best = std::min(best, ms);
+        total += ms;
+        runs++;
+    }
+    return best;
+}
+
+static float maxDiff(const glm::vec3& a, const glm::vec3& b)
+{
+    return std::max(std::fabs(a.x - b.x), std::max(std::fabs(a.y - b.y), std::fabs(a.z - b.z)));
+}
+
+static void benchMesh(const benchMeshT& mesh)
+{
+    const std::vector<glm::vec3>& vertices = mesh.vertices;
+    std::printf("\n%zu vertices, %zu triangles\n", vertices.size(), mesh.indices.size() / 3);
+    std::printf("%-10s %-8s %10s %9s %10s\n", "kernel", "set", "ms", "speedup", "max diff");
+
+    // Legacy loops (two passes)
+    glm::vec3 center, bMin, bMax;
+    double legacyMs = timeBest([&] {
+        center = legacyCenter(vertices);
+        legacyBox(vertices, bMin, bMax);
+    });
+    std::printf("%-10s %-8s %10.4f %9s %10s\n", "bounds", "legacy", legacyMs, "1.00x", "-");
+
+    // Scalar kernel set results are the reference for the others
+    meshBoundsT refBounds = {};
+    boundingSphereT refSphere = {};
+    std::vector<glm::vec3> refNormals, refFaceNormals;
+    std::vector<glm::vec4> refTangents;
+    double scalarMs[4] = {};
+    unsigned int supported = setMeshKernels(MESH_KERNELS_AVX2);
+    for (unsigned int kernels = MESH_KERNELS_SCALAR; kernels <= supported; kernels++)
+    {
+        setMeshKernels(kernels);
+        const char* name = getMeshKernelsName(kernels);
+
+        meshBoundsT bounds;
+        double ms = timeBest([&] { bounds = computeCentroidBounds(vertices); });
+        float diff = std::max(maxDiff(bounds.centroid, center),
+                              std::max(maxDiff(bounds.bMin, bMin), maxDiff(bounds.bMax, bMax)));
+        std::printf("%-10s %-8s %10.4f %8.2fx %10.3g\n", "bounds", name, ms, legacyMs / ms, diff);
+
+        boundingSphereT sphere;
+        double sphereMs = timeBest([&] { sphere = computeBoundingSphere(vertices, bounds); });
+
+        std::vector<glm::vec3> normals;
+        double normalMs = timeBest([&] {
+            normals = mesh.normals;
+            renormalizeNormals(normals);
+        });
+        std::vector<glm::vec3> faceNormals;
+        double faceMs = timeBest([&] { computeNormals(vertices, mesh.indices, faceNormals); });
+        std::vector<glm::vec4> tangents;
+        double tangentMs = timeBest([&] { computeTangents(vertices, mesh.uvs, faceNormals, mesh.indices, tangents); });
+
+        if (kernels == MESH_KERNELS_SCALAR)
+        {
+            refBounds = bounds;
+            refSphere = sphere;
+            refNormals = normals;
+            refFaceNormals = faceNormals;
+            refTangents = tangents;
+            scalarMs[0] = sphereMs;
+            scalarMs[1] = normalMs;
+            scalarMs[2] = faceMs;
+            scalarMs[3] = tangentMs;
+        }
+
+        float sphereDiff = std::max(maxDiff(sphere.center, refSphere.center), std::fabs(sphere.radius - refSphere.radius));
+        float normalDiff = 0.f, faceDiff = 0.f, tangentDiff = 0.f;
+        for (std::size_t i = 0; i < vertices.size(); i++)
+        {
+            normalDiff = std::max(normalDiff, maxDiff(normals[i], refNormals[i]));
+            faceDiff = std::max(faceDiff, maxDiff(faceNormals[i], refFaceNormals[i]));
+            tangentDiff = std::max(tangentDiff, std::max(maxDiff(glm::vec3(tangents[i].x, tangents[i].y, tangents[i].z),
+                                                                 glm::vec3(refTangents[i].x, refTangents[i].y, refTangents[i].z)),
+                                                         std::fabs(tangents[i].w - refTangents[i].w)));
+        }
+        std::printf("%-10s %-8s %10.4f %8.2fx %10.3g\n", "sphere", name, sphereMs, scalarMs[0] / sphereMs, sphereDiff);
+        std::printf("%-10s %-8s %10.4f %8.2fx %10.3g\n", "normalize", name, normalMs, scalarMs[1] / normalMs, normalDiff);
+        std::printf("%-10s %-8s %10.4f %8.2fx %10.3g\n", "normals", name, faceMs, scalarMs[2] / faceMs, faceDiff);
+        std::printf("%-10s %-8s %10.4f %8.2fx %10.3g\n", "tangents", name, tangentMs, scalarMs[3] / tangentMs, tangentDiff);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<unsigned int> sizes;
+    for (int a = 1; a < argc; a++)
+    {
+        sizes.push_back(static_cast<unsigned int>(std::strtoul(argv[a], nullptr, 10)));
+    }
+    if (sizes.empty())
+    {
+        sizes = {4096, 16384, 65025};
+    }
+
+    std::printf("Threads: %u, best kernel set: %s\n", getMeshWorkers().getThreadCount(),
+                getMeshKernelsName(getMeshKernels()));
+    for (unsigned int size : sizes)
+    {
+        benchMesh(makeMesh(size));
+    }
+    return 0;
+}
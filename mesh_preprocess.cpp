@@ -0,0 +1,855 @@
+#include "mesh_preprocess.hpp"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MESH_KERNELS_X86
+// Per function targets, so the viewer needs no -mavx2 and still runs on older CPUs
+#define MESH_SSE2 __attribute__((target("sse2")))
+#define MESH_AVX2 __attribute__((target("avx2")))
+#endif
+
+meshWorkerPool::meshWorkerPool(unsigned int workerCnt)
+{
+    job = nullptr;
+    generation = 0;
+    stopping = false;
+    for (unsigned int i = 0; i < workerCnt; i++)
+    {
+        workers.emplace_back(&meshWorkerPool::workerLoop, this);
+    }
+}
+
+meshWorkerPool::~meshWorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+void meshWorkerPool::runParts(jobT& current, std::unique_lock<std::mutex>& lock)
+{
+    while (current.nextPart < current.parts)
+    {
+        unsigned int part = current.nextPart++;
+        lock.unlock();
+        std::size_t begin = current.count * part / current.parts;
+        std::size_t end = current.count * (part + 1) / current.parts;
+        (*current.fn)(part, begin, end);
+        lock.lock();
+    }
+}
+
+void meshWorkerPool::workerLoop()
+{
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(mtx);
+    while (true)
+    {
+        wake.wait(lock, [&] { return stopping || (job != nullptr && generation != seen); });
+        if (stopping)
+        {
+            return;
+        }
+        seen = generation;
+        jobT& current = *job;
+        current.active++;
+        runParts(current, lock);
+        if (--current.active == 0)
+        {
+            idle.notify_all();
+        }
+    }
+}
+
+unsigned int meshWorkerPool::getThreadCount() const
+{
+    return static_cast<unsigned int>(workers.size()) + 1;
+}
+
+unsigned int meshWorkerPool::getPartCount(std::size_t count, std::size_t grain) const
+{
+    std::size_t parts = (count + std::max<std::size_t>(grain, 1) - 1) / std::max<std::size_t>(grain, 1);
+    return static_cast<unsigned int>(std::min<std::size_t>(parts, getThreadCount()));
+}
+
+void meshWorkerPool::parallelFor(std::size_t count, std::size_t grain, const partFnT& fn)
+{
+    unsigned int parts = getPartCount(count, grain);
+    if (parts <= 1)
+    {
+        if (count > 0)
+        {
+            fn(0, 0, count);
+        }
+        return;
+    }
+
+    jobT current = {&fn, count, parts, 0, 0};
+    std::unique_lock<std::mutex> lock(mtx);
+    job = &current;
+    generation++;
+    lock.unlock();
+    wake.notify_all();
+    lock.lock();
+    runParts(current, lock);
+
+    // Every part is claimed: detach the job and wait for the workers still on one
+    job = nullptr;
+    idle.wait(lock, [&] { return current.active == 0; });
+}
+
+meshWorkerPool& getMeshWorkers()
+{
+    static meshWorkerPool pool(std::max(std::thread::hardware_concurrency(), 1U) - 1);
+    return pool;
+}
+
+static unsigned int getSupportedKernels()
+{
+#if defined(MESH_KERNELS_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return MESH_KERNELS_AVX2;
+    }
+    if (__builtin_cpu_supports("sse2"))
+    {
+        return MESH_KERNELS_SSE2;
+    }
+#endif
+    return MESH_KERNELS_SCALAR;
+}
+
+static unsigned int& kernelsInUse()
+{
+    static unsigned int kernels = getSupportedKernels();
+    return kernels;
+}
+
+unsigned int getMeshKernels()
+{
+    return kernelsInUse();
+}
+
+unsigned int setMeshKernels(unsigned int kernels)
+{
+    static const unsigned int supported = getSupportedKernels();
+    kernelsInUse() = std::min(kernels, supported);
+    return kernelsInUse();
+}
+
+const char* getMeshKernelsName(unsigned int kernels)
+{
+    switch (kernels)
+    {
+    case MESH_KERNELS_AVX2:
+        return "avx2";
+    case MESH_KERNELS_SSE2:
+        return "sse2";
+    default:
+        return "scalar";
+    }
+}
+
+// Partial result of the fused centroid and bounds pass
+typedef struct
+{
+    glm::vec3 sum;
+    glm::vec3 bMin;
+    glm::vec3 bMax;
+} boundsPartT;
+
+static void initBoundsPart(const glm::vec3& first, boundsPartT& part)
+{
+    part.sum = glm::vec3(0.f);
+    part.bMin = first;
+    part.bMax = first;
+}
+
+static void boundsScalar(const glm::vec3* v, std::size_t n, boundsPartT& part)
+{
+    for (std::size_t i = 0; i < n; i++)
+    {
+        part.sum += v[i];
+        part.bMin = glm::min(part.bMin, v[i]);
+        part.bMax = glm::max(part.bMax, v[i]);
+    }
+}
+
+// Folds SIMD lanes holding interleaved xyz floats (lane k is component k % 3)
+static void foldBoundsLanes(const float* sum, const float* lo, const float* hi, unsigned int lanes,
+                            boundsPartT& part)
+{
+    for (unsigned int k = 0; k < lanes; k++)
+    {
+        part.sum[k % 3] += sum[k];
+        part.bMin[k % 3] = std::min(part.bMin[k % 3], lo[k]);
+        part.bMax[k % 3] = std::max(part.bMax[k % 3], hi[k]);
+    }
+}
+
+static std::size_t renormalizeScalar(glm::vec3* n, std::size_t cnt)
+{
+    std::size_t zeroCnt = 0;
+    for (std::size_t i = 0; i < cnt; i++)
+    {
+        float len2 = glm::dot(n[i], n[i]);
+        if (len2 > MESH_MIN_LENGTH2)
+        {
+            n[i] = n[i] * (1.f / std::sqrt(len2));
+        }
+        else
+        {
+            zeroCnt++;
+        }
+    }
+    return zeroCnt;
+}
+
+static void sphereScalar(const glm::vec3* v, std::size_t n, const glm::vec3& c0, const glm::vec3& c1,
+                         float& d0, float& d1)
+{
+    for (std::size_t i = 0; i < n; i++)
+    {
+        d0 = std::max(d0, glm::dot(v[i] - c0, v[i] - c0));
+        d1 = std::max(d1, glm::dot(v[i] - c1, v[i] - c1));
+    }
+}
+
+// Unit vector perpendicular to a normal (tangent of a vertex without UV gradient)
+static glm::vec3 anyPerpendicular(const glm::vec3& normal)
+{
+    glm::vec3 axis = std::fabs(normal.x) < 0.9f ? glm::vec3(1.f, 0.f, 0.f) : glm::vec3(0.f, 1.f, 0.f);
+    glm::vec3 t = glm::cross(normal, axis);
+    float len2 = glm::dot(t, t);
+    return len2 > MESH_MIN_LENGTH2 ? t * (1.f / std::sqrt(len2)) : glm::vec3(1.f, 0.f, 0.f);
+}
+
+// Gram-Schmidt of the accumulated UV gradients against the normals
+static void tangentsScalar(const glm::vec3* n, const glm::vec3* sDir, const glm::vec3* tDir, std::size_t cnt,
+                           glm::vec4* out)
+{
+    for (std::size_t i = 0; i < cnt; i++)
+    {
+        glm::vec3 t = sDir[i] - n[i] * glm::dot(n[i], sDir[i]);
+        float len2 = glm::dot(t, t);
+        t = len2 > MESH_MIN_LENGTH2 ? t * (1.f / std::sqrt(len2)) : anyPerpendicular(n[i]);
+        out[i] = glm::vec4(t, glm::dot(glm::cross(n[i], t), tDir[i]) < 0.f ? -1.f : 1.f);
+    }
+}
+
+#if defined(MESH_KERNELS_X86)
+
+// Four packed xyz vertices (12 floats) to one register per component and back
+MESH_SSE2 static inline void load3Sse2(const float* f, __m128& x, __m128& y, __m128& z)
+{
+    __m128 r0 = _mm_loadu_ps(f);          // x0 y0 z0 x1
+    __m128 r1 = _mm_loadu_ps(f + 4);      // y1 z1 x2 y2
+    __m128 r2 = _mm_loadu_ps(f + 8);      // z2 x3 y3 z3
+    __m128 t0 = _mm_shuffle_ps(r1, r2, _MM_SHUFFLE(2, 1, 3, 2));   // x2 y2 x3 y3
+    __m128 t1 = _mm_shuffle_ps(r0, r1, _MM_SHUFFLE(1, 0, 2, 1));   // y0 z0 y1 z1
+    x = _mm_shuffle_ps(r0, t0, _MM_SHUFFLE(2, 0, 3, 0));
+    y = _mm_shuffle_ps(t1, t0, _MM_SHUFFLE(3, 1, 2, 0));
+    z = _mm_shuffle_ps(t1, r2, _MM_SHUFFLE(3, 0, 3, 1));
+}
+
+MESH_SSE2 static inline void store3Sse2(float* f, __m128 x, __m128 y, __m128 z)
+{
+    __m128 xyLo = _mm_unpacklo_ps(x, y);                            // x0 y0 x1 y1
+    __m128 xyHi = _mm_unpackhi_ps(x, y);                            // x2 y2 x3 y3
+    __m128 zx = _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0));      // z0 z0 x1 x1
+    __m128 yz = _mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1));      // y1 y1 z1 z1
+    __m128 t = _mm_shuffle_ps(xyHi, z, _MM_SHUFFLE(3, 2, 3, 2));    // x3 y3 z2 z3
+    _mm_storeu_ps(f, _mm_shuffle_ps(xyLo, zx, _MM_SHUFFLE(2, 0, 1, 0)));
+    _mm_storeu_ps(f + 4, _mm_shuffle_ps(yz, xyHi, _MM_SHUFFLE(1, 0, 2, 0)));
+    _mm_storeu_ps(f + 8, _mm_shuffle_ps(t, t, _MM_SHUFFLE(3, 1, 0, 2)));
+}
+
+MESH_SSE2 static inline __m128 selectSse2(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+MESH_SSE2 static void boundsSse2(const glm::vec3* v, std::size_t n, boundsPartT& part)
+{
+    const float* f = &v[0].x;
+    std::size_t blocks = n / 4;
+    // The first vertex repeated in the lane pattern seeds the min and max
+    float seed[12];
+    for (unsigned int k = 0; k < 12; k++)
+    {
+        seed[k] = f[k % 3];
+    }
+    __m128 s0 = _mm_setzero_ps(), s1 = s0, s2 = s0;
+    __m128 lo0 = _mm_loadu_ps(seed), lo1 = _mm_loadu_ps(seed + 4), lo2 = _mm_loadu_ps(seed + 8);
+    __m128 hi0 = lo0, hi1 = lo1, hi2 = lo2;
+    for (std::size_t b = 0; b < blocks; b++, f += 12)
+    {
+        __m128 r0 = _mm_loadu_ps(f), r1 = _mm_loadu_ps(f + 4), r2 = _mm_loadu_ps(f + 8);
+        s0 = _mm_add_ps(s0, r0);
+        s1 = _mm_add_ps(s1, r1);
+        s2 = _mm_add_ps(s2, r2);
+        lo0 = _mm_min_ps(lo0, r0);
+        lo1 = _mm_min_ps(lo1, r1);
+        lo2 = _mm_min_ps(lo2, r2);
+        hi0 = _mm_max_ps(hi0, r0);
+        hi1 = _mm_max_ps(hi1, r1);
+        hi2 = _mm_max_ps(hi2, r2);
+    }
+    float sum[12], lo[12], hi[12];
+    _mm_storeu_ps(sum, s0);
+    _mm_storeu_ps(sum + 4, s1);
+    _mm_storeu_ps(sum + 8, s2);
+    _mm_storeu_ps(lo, lo0);
+    _mm_storeu_ps(lo + 4, lo1);
+    _mm_storeu_ps(lo + 8, lo2);
+    _mm_storeu_ps(hi, hi0);
+    _mm_storeu_ps(hi + 4, hi1);
+    _mm_storeu_ps(hi + 8, hi2);
+    foldBoundsLanes(sum, lo, hi, 12, part);
+    boundsScalar(v + 4 * blocks, n - 4 * blocks, part);
+}
+
+MESH_SSE2 static std::size_t renormalizeSse2(glm::vec3* n, std::size_t cnt)
+{
+    const __m128 minLength2 = _mm_set1_ps(MESH_MIN_LENGTH2);
+    const __m128 one = _mm_set1_ps(1.f);
+    std::size_t blocks = cnt / 4;
+    std::size_t zeroCnt = 0;
+    float* f = &n[0].x;
+    for (std::size_t b = 0; b < blocks; b++, f += 12)
+    {
+        __m128 x, y, z;
+        load3Sse2(f, x, y, z);
+        __m128 len2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+        __m128 valid = _mm_cmpgt_ps(len2, minLength2);
+        __m128 inv = _mm_div_ps(one, _mm_sqrt_ps(len2));
+        x = selectSse2(valid, _mm_mul_ps(x, inv), x);
+        y = selectSse2(valid, _mm_mul_ps(y, inv), y);
+        z = selectSse2(valid, _mm_mul_ps(z, inv), z);
+        store3Sse2(f, x, y, z);
+        zeroCnt += 4 - __builtin_popcount(_mm_movemask_ps(valid));
+    }
+    return zeroCnt + renormalizeScalar(n + 4 * blocks, cnt - 4 * blocks);
+}
+
+MESH_SSE2 static void sphereSse2(const glm::vec3* v, std::size_t n, const glm::vec3& c0, const glm::vec3& c1,
+                                 float& d0, float& d1)
+{
+    const __m128 c0x = _mm_set1_ps(c0.x), c0y = _mm_set1_ps(c0.y), c0z = _mm_set1_ps(c0.z);
+    const __m128 c1x = _mm_set1_ps(c1.x), c1y = _mm_set1_ps(c1.y), c1z = _mm_set1_ps(c1.z);
+    std::size_t blocks = n / 4;
+    const float* f = &v[0].x;
+    __m128 m0 = _mm_set1_ps(d0), m1 = _mm_set1_ps(d1);
+    for (std::size_t b = 0; b < blocks; b++, f += 12)
+    {
+        __m128 x, y, z;
+        load3Sse2(f, x, y, z);
+        __m128 dx = _mm_sub_ps(x, c0x), dy = _mm_sub_ps(y, c0y), dz = _mm_sub_ps(z, c0z);
+        m0 = _mm_max_ps(m0, _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+        dx = _mm_sub_ps(x, c1x);
+        dy = _mm_sub_ps(y, c1y);
+        dz = _mm_sub_ps(z, c1z);
+        m1 = _mm_max_ps(m1, _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+    }
+    float lanes0[4], lanes1[4];
+    _mm_storeu_ps(lanes0, m0);
+    _mm_storeu_ps(lanes1, m1);
+    d0 = std::max(std::max(lanes0[0], lanes0[1]), std::max(lanes0[2], lanes0[3]));
+    d1 = std::max(std::max(lanes1[0], lanes1[1]), std::max(lanes1[2], lanes1[3]));
+    sphereScalar(v + 4 * blocks, n - 4 * blocks, c0, c1, d0, d1);
+}
+
+MESH_SSE2 static void tangentsSse2(const glm::vec3* n, const glm::vec3* sDir, const glm::vec3* tDir,
+                                   std::size_t cnt, glm::vec4* out)
+{
+    const __m128 minLength2 = _mm_set1_ps(MESH_MIN_LENGTH2);
+    const __m128 one = _mm_set1_ps(1.f);
+    const __m128 signBit = _mm_set1_ps(-0.f);
+    std::size_t blocks = cnt / 4;
+    for (std::size_t b = 0; b < blocks; b++)
+    {
+        __m128 nx, ny, nz, sx, sy, sz, tx, ty, tz;
+        load3Sse2(&n[4 * b].x, nx, ny, nz);
+        load3Sse2(&sDir[4 * b].x, sx, sy, sz);
+        load3Sse2(&tDir[4 * b].x, tx, ty, tz);
+
+        __m128 ns = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, sx), _mm_mul_ps(ny, sy)), _mm_mul_ps(nz, sz));
+        __m128 x = _mm_sub_ps(sx, _mm_mul_ps(nx, ns));
+        __m128 y = _mm_sub_ps(sy, _mm_mul_ps(ny, ns));
+        __m128 z = _mm_sub_ps(sz, _mm_mul_ps(nz, ns));
+        __m128 len2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+        if (_mm_movemask_ps(_mm_cmpgt_ps(len2, minLength2)) != 0xF)
+        { // Rare vertex without UV gradient
+            tangentsScalar(n + 4 * b, sDir + 4 * b, tDir + 4 * b, 4, out + 4 * b);
+            continue;
+        }
+        __m128 inv = _mm_div_ps(one, _mm_sqrt_ps(len2));
+        x = _mm_mul_ps(x, inv);
+        y = _mm_mul_ps(y, inv);
+        z = _mm_mul_ps(z, inv);
+
+        // Handedness: sign of dot(cross(n, t), tDir)
+        __m128 bx = _mm_sub_ps(_mm_mul_ps(ny, z), _mm_mul_ps(nz, y));
+        __m128 by = _mm_sub_ps(_mm_mul_ps(nz, x), _mm_mul_ps(nx, z));
+        __m128 bz = _mm_sub_ps(_mm_mul_ps(nx, y), _mm_mul_ps(ny, x));
+        __m128 bt = _mm_add_ps(_mm_add_ps(_mm_mul_ps(bx, tx), _mm_mul_ps(by, ty)), _mm_mul_ps(bz, tz));
+        __m128 w = _mm_or_ps(one, _mm_and_ps(signBit, _mm_cmplt_ps(bt, _mm_setzero_ps())));
+
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+        float* o = &out[4 * b].x;
+        _mm_storeu_ps(o, x);
+        _mm_storeu_ps(o + 4, y);
+        _mm_storeu_ps(o + 8, z);
+        _mm_storeu_ps(o + 12, w);
+    }
+    tangentsScalar(n + 4 * blocks, sDir + 4 * blocks, tDir + 4 * blocks, cnt - 4 * blocks, out + 4 * blocks);
+}
+
+// Eight packed xyz vertices as two SSE transposes side by side (shuffles stay in lane)
+MESH_AVX2 static inline __m256 load2x4Avx2(const float* f)
+{
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(f)), _mm_loadu_ps(f + 12), 1);
+}
+
+MESH_AVX2 static inline void store2x4Avx2(float* f, __m256 r)
+{
+    _mm_storeu_ps(f, _mm256_castps256_ps128(r));
+    _mm_storeu_ps(f + 12, _mm256_extractf128_ps(r, 1));
+}
+
+MESH_AVX2 static inline void load3Avx2(const float* f, __m256& x, __m256& y, __m256& z)
+{
+    __m256 r0 = load2x4Avx2(f);
+    __m256 r1 = load2x4Avx2(f + 4);
+    __m256 r2 = load2x4Avx2(f + 8);
+    __m256 t0 = _mm256_shuffle_ps(r1, r2, _MM_SHUFFLE(2, 1, 3, 2));
+    __m256 t1 = _mm256_shuffle_ps(r0, r1, _MM_SHUFFLE(1, 0, 2, 1));
+    x = _mm256_shuffle_ps(r0, t0, _MM_SHUFFLE(2, 0, 3, 0));
+    y = _mm256_shuffle_ps(t1, t0, _MM_SHUFFLE(3, 1, 2, 0));
+    z = _mm256_shuffle_ps(t1, r2, _MM_SHUFFLE(3, 0, 3, 1));
+}
+
+MESH_AVX2 static inline void store3Avx2(float* f, __m256 x, __m256 y, __m256 z)
+{
+    __m256 xyLo = _mm256_unpacklo_ps(x, y);
+    __m256 xyHi = _mm256_unpackhi_ps(x, y);
+    __m256 zx = _mm256_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0));
+    __m256 yz = _mm256_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1));
+    __m256 t = _mm256_shuffle_ps(xyHi, z, _MM_SHUFFLE(3, 2, 3, 2));
+    store2x4Avx2(f, _mm256_shuffle_ps(xyLo, zx, _MM_SHUFFLE(2, 0, 1, 0)));
+    store2x4Avx2(f + 4, _mm256_shuffle_ps(yz, xyHi, _MM_SHUFFLE(1, 0, 2, 0)));
+    store2x4Avx2(f + 8, _mm256_shuffle_ps(t, t, _MM_SHUFFLE(3, 1, 0, 2)));
+}
+
+MESH_AVX2 static inline __m256 dot3Avx2(__m256 ax, __m256 ay, __m256 az, __m256 bx, __m256 by, __m256 bz)
+{
+    return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax, bx), _mm256_mul_ps(ay, by)), _mm256_mul_ps(az, bz));
+}
+
+MESH_AVX2 static void boundsAvx2(const glm::vec3* v, std::size_t n, boundsPartT& part)
+{
+    const float* f = &v[0].x;
+    std::size_t blocks = n / 8;
+    float seed[24];
+    for (unsigned int k = 0; k < 24; k++)
+    {
+        seed[k] = f[k % 3];
+    }
+    __m256 s0 = _mm256_setzero_ps(), s1 = s0, s2 = s0;
+    __m256 lo0 = _mm256_loadu_ps(seed), lo1 = _mm256_loadu_ps(seed + 8), lo2 = _mm256_loadu_ps(seed + 16);
+    __m256 hi0 = lo0, hi1 = lo1, hi2 = lo2;
+    for (std::size_t b = 0; b < blocks; b++, f += 24)
+    {
+        __m256 r0 = _mm256_loadu_ps(f), r1 = _mm256_loadu_ps(f + 8), r2 = _mm256_loadu_ps(f + 16);
+        s0 = _mm256_add_ps(s0, r0);
+        s1 = _mm256_add_ps(s1, r1);
+        s2 = _mm256_add_ps(s2, r2);
+        lo0 = _mm256_min_ps(lo0, r0);
+        lo1 = _mm256_min_ps(lo1, r1);
+        lo2 = _mm256_min_ps(lo2, r2);
+        hi0 = _mm256_max_ps(hi0, r0);
+        hi1 = _mm256_max_ps(hi1, r1);
+        hi2 = _mm256_max_ps(hi2, r2);
+    }
+    float sum[24], lo[24], hi[24];
+    _mm256_storeu_ps(sum, s0);
+    _mm256_storeu_ps(sum + 8, s1);
+    _mm256_storeu_ps(sum + 16, s2);
+    _mm256_storeu_ps(lo, lo0);
+    _mm256_storeu_ps(lo + 8, lo1);
+    _mm256_storeu_ps(lo + 16, lo2);
+    _mm256_storeu_ps(hi, hi0);
+    _mm256_storeu_ps(hi + 8, hi1);
+    _mm256_storeu_ps(hi + 16, hi2);
+    foldBoundsLanes(sum, lo, hi, 24, part);
+    boundsScalar(v + 8 * blocks, n - 8 * blocks, part);
+}
+
+MESH_AVX2 static std::size_t renormalizeAvx2(glm::vec3* n, std::size_t cnt)
+{
+    const __m256 minLength2 = _mm256_set1_ps(MESH_MIN_LENGTH2);
+    const __m256 one = _mm256_set1_ps(1.f);
+    std::size_t blocks = cnt / 8;
+    std::size_t zeroCnt = 0;
+    float* f = &n[0].x;
+    for (std::size_t b = 0; b < blocks; b++, f += 24)
+    {
+        __m256 x, y, z;
+        load3Avx2(f, x, y, z);
+        __m256 len2 = dot3Avx2(x, y, z, x, y, z);
+        __m256 valid = _mm256_cmp_ps(len2, minLength2, _CMP_GT_OQ);
+        __m256 inv = _mm256_div_ps(one, _mm256_sqrt_ps(len2));
+        x = _mm256_blendv_ps(x, _mm256_mul_ps(x, inv), valid);
+        y = _mm256_blendv_ps(y, _mm256_mul_ps(y, inv), valid);
+        z = _mm256_blendv_ps(z, _mm256_mul_ps(z, inv), valid);
+        store3Avx2(f, x, y, z);
+        zeroCnt += 8 - __builtin_popcount(_mm256_movemask_ps(valid));
+    }
+    return zeroCnt + renormalizeSse2(n + 8 * blocks, cnt - 8 * blocks);
+}
+
+MESH_AVX2 static void sphereAvx2(const glm::vec3* v, std::size_t n, const glm::vec3& c0, const glm::vec3& c1,
+                                 float& d0, float& d1)
+{
+    const __m256 c0x = _mm256_set1_ps(c0.x), c0y = _mm256_set1_ps(c0.y), c0z = _mm256_set1_ps(c0.z);
+    const __m256 c1x = _mm256_set1_ps(c1.x), c1y = _mm256_set1_ps(c1.y), c1z = _mm256_set1_ps(c1.z);
+    std::size_t blocks = n / 8;
+    const float* f = &v[0].x;
+    __m256 m0 = _mm256_set1_ps(d0), m1 = _mm256_set1_ps(d1);
+    for (std::size_t b = 0; b < blocks; b++, f += 24)
+    {
+        __m256 x, y, z;
+        load3Avx2(f, x, y, z);
+        __m256 dx = _mm256_sub_ps(x, c0x), dy = _mm256_sub_ps(y, c0y), dz = _mm256_sub_ps(z, c0z);
+        m0 = _mm256_max_ps(m0, dot3Avx2(dx, dy, dz, dx, dy, dz));
+        dx = _mm256_sub_ps(x, c1x);
+        dy = _mm256_sub_ps(y, c1y);
+        dz = _mm256_sub_ps(z, c1z);
+        m1 = _mm256_max_ps(m1, dot3Avx2(dx, dy, dz, dx, dy, dz));
+    }
+    float lanes0[8], lanes1[8];
+    _mm256_storeu_ps(lanes0, m0);
+    _mm256_storeu_ps(lanes1, m1);
+    d0 = *std::max_element(lanes0, lanes0 + 8);
+    d1 = *std::max_element(lanes1, lanes1 + 8);
+    sphereSse2(v + 8 * blocks, n - 8 * blocks, c0, c1, d0, d1);
+}
+
+MESH_AVX2 static void tangentsAvx2(const glm::vec3* n, const glm::vec3* sDir, const glm::vec3* tDir,
+                                   std::size_t cnt, glm::vec4* out)
+{
+    const __m256 minLength2 = _mm256_set1_ps(MESH_MIN_LENGTH2);
+    const __m256 one = _mm256_set1_ps(1.f);
+    const __m256 signBit = _mm256_set1_ps(-0.f);
+    std::size_t blocks = cnt / 8;
+    for (std::size_t b = 0; b < blocks; b++)
+    {
+        __m256 nx, ny, nz, sx, sy, sz, tx, ty, tz;
+        load3Avx2(&n[8 * b].x, nx, ny, nz);
+        load3Avx2(&sDir[8 * b].x, sx, sy, sz);
+        load3Avx2(&tDir[8 * b].x, tx, ty, tz);
+
+        __m256 ns = dot3Avx2(nx, ny, nz, sx, sy, sz);
+        __m256 x = _mm256_sub_ps(sx, _mm256_mul_ps(nx, ns));
+        __m256 y = _mm256_sub_ps(sy, _mm256_mul_ps(ny, ns));
+        __m256 z = _mm256_sub_ps(sz, _mm256_mul_ps(nz, ns));
+        __m256 len2 = dot3Avx2(x, y, z, x, y, z);
+        if (_mm256_movemask_ps(_mm256_cmp_ps(len2, minLength2, _CMP_GT_OQ)) != 0xFF)
+        { // Rare vertex without UV gradient
+            tangentsScalar(n + 8 * b, sDir + 8 * b, tDir + 8 * b, 8, out + 8 * b);
+            continue;
+        }
+        __m256 inv = _mm256_div_ps(one, _mm256_sqrt_ps(len2));
+        x = _mm256_mul_ps(x, inv);
+        y = _mm256_mul_ps(y, inv);
+        z = _mm256_mul_ps(z, inv);
+
+        __m256 bx = _mm256_sub_ps(_mm256_mul_ps(ny, z), _mm256_mul_ps(nz, y));
+        __m256 by = _mm256_sub_ps(_mm256_mul_ps(nz, x), _mm256_mul_ps(nx, z));
+        __m256 bz = _mm256_sub_ps(_mm256_mul_ps(nx, y), _mm256_mul_ps(ny, x));
+        __m256 bt = dot3Avx2(bx, by, bz, tx, ty, tz);
+        __m256 w = _mm256_or_ps(one, _mm256_and_ps(signBit, _mm256_cmp_ps(bt, _mm256_setzero_ps(), _CMP_LT_OQ)));
+
+        // In lane 4x4 transposes: the low halves are vertices 0-3, the high ones 4-7
+        __m256 t0 = _mm256_unpacklo_ps(x, y);
+        __m256 t1 = _mm256_unpacklo_ps(z, w);
+        __m256 t2 = _mm256_unpackhi_ps(x, y);
+        __m256 t3 = _mm256_unpackhi_ps(z, w);
+        float* o = &out[8 * b].x;
+        __m256 rows[4] = {_mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0)),
+                          _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2)),
+                          _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0)),
+                          _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(3, 2, 3, 2))};
+        for (unsigned int r = 0; r < 4; r++)
+        {
+            _mm_storeu_ps(o + 4 * r, _mm256_castps256_ps128(rows[r]));
+            _mm_storeu_ps(o + 16 + 4 * r, _mm256_extractf128_ps(rows[r], 1));
+        }
+    }
+    tangentsSse2(n + 8 * blocks, sDir + 8 * blocks, tDir + 8 * blocks, cnt - 8 * blocks, out + 8 * blocks);
+}
+
+#endif
+
+static void boundsKernel(const glm::vec3* v, std::size_t n, boundsPartT& part)
+{
+    initBoundsPart(v[0], part);
+#if defined(MESH_KERNELS_X86)
+    switch (getMeshKernels())
+    {
+    case MESH_KERNELS_AVX2:
+        boundsAvx2(v, n, part);
+        return;
+    case MESH_KERNELS_SSE2:
+        boundsSse2(v, n, part);
+        return;
+    }
+#endif
+    boundsScalar(v, n, part);
+}
+
+static std::size_t renormalizeKernel(glm::vec3* n, std::size_t cnt)
+{
+#if defined(MESH_KERNELS_X86)
+    switch (getMeshKernels())
+    {
+    case MESH_KERNELS_AVX2:
+        return renormalizeAvx2(n, cnt);
+    case MESH_KERNELS_SSE2:
+        return renormalizeSse2(n, cnt);
+    }
+#endif
+    return renormalizeScalar(n, cnt);
+}
+
+static void sphereKernel(const glm::vec3* v, std::size_t n, const glm::vec3& c0, const glm::vec3& c1,
+                         float& d0, float& d1)
+{
+#if defined(MESH_KERNELS_X86)
+    switch (getMeshKernels())
+    {
+    case MESH_KERNELS_AVX2:
+        sphereAvx2(v, n, c0, c1, d0, d1);
+        return;
+    case MESH_KERNELS_SSE2:
+        sphereSse2(v, n, c0, c1, d0, d1);
+        return;
+    }
+#endif
+    sphereScalar(v, n, c0, c1, d0, d1);
+}
+
+static void tangentsKernel(const glm::vec3* n, const glm::vec3* sDir, const glm::vec3* tDir, std::size_t cnt,
+                           glm::vec4* out)
+{
+#if defined(MESH_KERNELS_X86)
+    switch (getMeshKernels())
+    {
+    case MESH_KERNELS_AVX2:
+        tangentsAvx2(n, sDir, tDir, cnt, out);
+        return;
+    case MESH_KERNELS_SSE2:
+        tangentsSse2(n, sDir, tDir, cnt, out);
+        return;
+    }
+#endif
+    tangentsScalar(n, sDir, tDir, cnt, out);
+}
+
+meshBoundsT computeCentroidBounds(meshSpan<const glm::vec3> vertices)
+{
+    meshBoundsT bounds = {glm::vec3(0.f), glm::vec3(0.f), glm::vec3(0.f)};
+    if (vertices.empty())
+    {
+        return bounds;
+    }
+
+    meshWorkerPool& pool = getMeshWorkers();
+    std::vector<boundsPartT> parts(pool.getPartCount(vertices.size(), MESH_PARALLEL_GRAIN));
+    pool.parallelFor(vertices.size(), MESH_PARALLEL_GRAIN, [&](unsigned int part, std::size_t begin, std::size_t end)
+    {
+        boundsKernel(&vertices[begin], end - begin, parts[part]);
+    });
+
+    glm::vec3 sum = parts[0].sum;
+    bounds.bMin = parts[0].bMin;
+    bounds.bMax = parts[0].bMax;
+    for (std::size_t p = 1; p < parts.size(); p++)
+    {
+        sum += parts[p].sum;
+        bounds.bMin = glm::min(bounds.bMin, parts[p].bMin);
+        bounds.bMax = glm::max(bounds.bMax, parts[p].bMax);
+    }
+    bounds.centroid = sum / static_cast<float>(vertices.size());
+    return bounds;
+}
+
+std::size_t renormalizeNormals(meshSpan<glm::vec3> normals)
+{
+    meshWorkerPool& pool = getMeshWorkers();
+    std::vector<std::size_t> zeroCnts(pool.getPartCount(normals.size(), MESH_PARALLEL_GRAIN), 0);
+    pool.parallelFor(normals.size(), MESH_PARALLEL_GRAIN, [&](unsigned int part, std::size_t begin, std::size_t end)
+    {
+        zeroCnts[part] = renormalizeKernel(&normals[begin], end - begin);
+    });
+
+    std::size_t zeroCnt = 0;
+    for (std::size_t cnt : zeroCnts)
+    {
+        zeroCnt += cnt;
+    }
+    return zeroCnt;
+}
+
+// Adds per triangle vectors to the triangle's three vertices, in `channels`
+// sums sized to the vertex count. The face pass is bound by the index gathers
+// so it stays scalar; large meshes give every part its own sums, added in part
+// order afterwards.
+// triFn(first index of the triangle, values[channels]) -> false to skip the triangle
+template <typename triFnT>
+static void scatterTriangles(meshSpan<const unsigned short> indices, std::vector<glm::vec3>* sums,
+                             unsigned int channels, triFnT triFn)
+{
+    const std::size_t vertexCnt = sums[0].size();
+    const std::size_t triCnt = indices.size() / 3;
+    auto accumulate = [&](std::vector<glm::vec3>* out, std::size_t first, std::size_t last)
+    {
+        glm::vec3 values[2];
+        for (std::size_t t = first; t < last; t++)
+        {
+            const unsigned short* tri = &indices[3 * t];
+            if (tri[0] >= vertexCnt || tri[1] >= vertexCnt || tri[2] >= vertexCnt || !triFn(tri, values))
+            {
+                continue;
+            }
+            for (unsigned int c = 0; c < channels; c++)
+            {
+                out[c][tri[0]] += values[c];
+                out[c][tri[1]] += values[c];
+                out[c][tri[2]] += values[c];
+            }
+        }
+    };
+
+    meshWorkerPool& pool = getMeshWorkers();
+    unsigned int parts = pool.getPartCount(triCnt, MESH_PARALLEL_GRAIN);
+    if (parts <= 1)
+    {
+        accumulate(sums, 0, triCnt);
+        return;
+    }
+
+    // Part 0 accumulates in place
+    std::vector<std::vector<glm::vec3>> partSums((parts - 1) * channels,
+                                                 std::vector<glm::vec3>(vertexCnt, glm::vec3(0.f)));
+    pool.parallelFor(triCnt, MESH_PARALLEL_GRAIN, [&](unsigned int part, std::size_t begin, std::size_t end)
+    {
+        accumulate(part == 0 ? sums : &partSums[(part - 1) * channels], begin, end);
+    });
+    pool.parallelFor(vertexCnt, MESH_PARALLEL_GRAIN, [&](unsigned int, std::size_t begin, std::size_t end)
+    {
+        for (unsigned int c = 0; c < channels; c++)
+        {
+            for (unsigned int p = 1; p < parts; p++)
+            {
+                const std::vector<glm::vec3>& partSum = partSums[(p - 1) * channels + c];
+                for (std::size_t i = begin; i < end; i++)
+                {
+                    sums[c][i] += partSum[i];
+                }
+            }
+        }
+    });
+}
+
+void computeNormals(meshSpan<const glm::vec3> vertices, meshSpan<const unsigned short> indices,
+                    std::vector<glm::vec3>& normals)
+{
+    normals.assign(vertices.size(), glm::vec3(0.f));
+    if (vertices.empty())
+    {
+        return;
+    }
+
+    // Unnormalized face normals are twice the triangle area long
+    scatterTriangles(indices, &normals, 1, [&](const unsigned short* tri, glm::vec3* values)
+    {
+        values[0] = glm::cross(vertices[tri[1]] - vertices[tri[0]], vertices[tri[2]] - vertices[tri[0]]);
+        return true;
+    });
+    renormalizeNormals(normals);
+}
+
+void computeTangents(meshSpan<const glm::vec3> vertices, meshSpan<const glm::vec2> uvs,
+                     meshSpan<const glm::vec3> normals, meshSpan<const unsigned short> indices,
+                     std::vector<glm::vec4>& tangents)
+{
+    tangents.resize(normals.size() == vertices.size() ? vertices.size() : 0);
+    if (tangents.empty())
+    {
+        return;
+    }
+
+    // UV gradients of the faces (left at zero without texture coordinates)
+    std::vector<glm::vec3> dirs[2] = {std::vector<glm::vec3>(vertices.size(), glm::vec3(0.f)),
+                                      std::vector<glm::vec3>(vertices.size(), glm::vec3(0.f))};
+    if (uvs.size() == vertices.size())
+    {
+        scatterTriangles(indices, dirs, 2, [&](const unsigned short* tri, glm::vec3* values)
+        {
+            glm::vec3 e1 = vertices[tri[1]] - vertices[tri[0]];
+            glm::vec3 e2 = vertices[tri[2]] - vertices[tri[0]];
+            glm::vec2 d1 = uvs[tri[1]] - uvs[tri[0]];
+            glm::vec2 d2 = uvs[tri[2]] - uvs[tri[0]];
+            float det = d1.x * d2.y - d2.x * d1.y;
+            if (std::fabs(det) < MESH_MIN_LENGTH2)
+            {
+                return false;
+            }
+            float r = 1.f / det;
+            values[0] = (e1 * d2.y - e2 * d1.y) * r;
+            values[1] = (e2 * d1.x - e1 * d2.x) * r;
+            return true;
+        });
+    }
+
+    getMeshWorkers().parallelFor(vertices.size(), MESH_PARALLEL_GRAIN,
+                                 [&](unsigned int, std::size_t begin, std::size_t end)
+    {
+        tangentsKernel(&normals[begin], &dirs[0][begin], &dirs[1][begin], end - begin, &tangents[begin]);
+    });
+}
+
+boundingSphereT computeBoundingSphere(meshSpan<const glm::vec3> vertices, const meshBoundsT& bounds)
+{
+    glm::vec3 boxCenter = 0.5f * (bounds.bMin + bounds.bMax);
+    meshWorkerPool& pool = getMeshWorkers();
+    std::vector<glm::vec2> parts(pool.getPartCount(vertices.size(), MESH_PARALLEL_GRAIN), glm::vec2(0.f));
+    pool.parallelFor(vertices.size(), MESH_PARALLEL_GRAIN, [&](unsigned int part, std::size_t begin, std::size_t end)
+    {
+        sphereKernel(&vertices[begin], end - begin, boxCenter, bounds.centroid, parts[part].x, parts[part].y);
+    });
+
+    // Squared distances to the farthest vertex from each candidate centre
+    float boxDist2 = 0.f;
+    float centroidDist2 = 0.f;
+    for (const auto& part : parts)
+    {
+        boxDist2 = std::max(boxDist2, part.x);
+        centroidDist2 = std::max(centroidDist2, part.y);
+    }
+    if (boxDist2 <= centroidDist2)
+    {
+        return {boxCenter, std::sqrt(boxDist2)};
+    }
+    return {bounds.centroid, std::sqrt(centroidDist2)};
+}
@@ -0,0 +1,103 @@
+#ifndef MESH_PREPROCESS_HPP
+#define MESH_PREPROCESS_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <glm/glm.hpp>
+#include "mesh_arena.hpp"
+
+// Kernel sets, the best one the CPU supports is picked at the first call
+const unsigned int MESH_KERNELS_SCALAR = 0;
+const unsigned int MESH_KERNELS_SSE2 = 1;
+const unsigned int MESH_KERNELS_AVX2 = 2;
+
+// Vertices (or triangles) handed to one worker, smaller meshes stay on the caller
+const std::size_t MESH_PARALLEL_GRAIN = 16384;
+// Squared length under which a normal or tangent counts as zero
+const float MESH_MIN_LENGTH2 = 1e-20f;
+
+// Centroid (vertex average) and axis aligned bounds
+typedef struct
+{
+    glm::vec3 centroid;
+    glm::vec3 bMin;
+    glm::vec3 bMax;
+} meshBoundsT;
+
+typedef struct
+{
+    glm::vec3 center;
+    float radius;
+} boundingSphereT;
+
+// Fixed set of worker threads running index ranges of one job at a time.
+// The caller works too, so a pool without workers runs everything inline.
+class meshWorkerPool
+{
+private:
+    typedef std::function<void(unsigned int part, std::size_t begin, std::size_t end)> partFnT;
+    typedef struct
+    {
+        const partFnT* fn;
+        std::size_t count;
+        unsigned int parts;
+        unsigned int nextPart;     // Next unclaimed part (guarded by mtx)
+        unsigned int active;       // Workers attached to the job
+    } jobT;
+
+    std::vector<std::thread> workers;
+    std::mutex mtx;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    jobT* job;
+    uint64_t generation;
+    bool stopping;
+
+    void workerLoop();
+    void runParts(jobT& current, std::unique_lock<std::mutex>& lock);
+
+public:
+    explicit meshWorkerPool(unsigned int workerCnt);
+    ~meshWorkerPool();
+    meshWorkerPool(const meshWorkerPool&) = delete;
+    meshWorkerPool& operator=(const meshWorkerPool&) = delete;
+
+    // Threads sharing a job (workers plus the caller)
+    unsigned int getThreadCount() const;
+    // Parts a range of count items is split into
+    unsigned int getPartCount(std::size_t count, std::size_t grain) const;
+    // Calls fn on contiguous parts of [0, count) (part numbers follow the order
+    // of the ranges, so per part results can be merged deterministically)
+    void parallelFor(std::size_t count, std::size_t grain, const partFnT& fn);
+};
+
+// Pool shared by the mesh kernels (one worker per extra hardware thread)
+meshWorkerPool& getMeshWorkers();
+
+// Kernel set in use, and an override for benchmarks (clamped to what the CPU supports)
+unsigned int getMeshKernels();
+unsigned int setMeshKernels(unsigned int kernels);
+const char* getMeshKernelsName(unsigned int kernels);
+
+// Centroid and bounds in one pass over the vertices
+meshBoundsT computeCentroidBounds(meshSpan<const glm::vec3> vertices);
+// Scales the normals to unit length (zero length normals are left as they are)
+// Output: number of zero length normals
+std::size_t renormalizeNormals(meshSpan<glm::vec3> normals);
+// Area weighted vertex normals of an indexed triangle list
+void computeNormals(meshSpan<const glm::vec3> vertices, meshSpan<const unsigned short> indices,
+                    std::vector<glm::vec3>& normals);
+// Per vertex tangents from the UV layout (normals must be unit length),
+// w holds the bitangent sign: bitangent = w * cross(normal, tangent)
+void computeTangents(meshSpan<const glm::vec3> vertices, meshSpan<const glm::vec2> uvs,
+                     meshSpan<const glm::vec3> normals, meshSpan<const unsigned short> indices,
+                     std::vector<glm::vec4>& tangents);
+// Enclosing sphere centred on the box centre or the centroid, whichever is tighter
+boundingSphereT computeBoundingSphere(meshSpan<const glm::vec3> vertices, const meshBoundsT& bounds);
+
+#endif
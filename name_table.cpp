@@ -0,0 +1,39 @@
+#include "name_table.hpp"
+
+unsigned int nameTable::intern(std::string_view name)
+{
+    auto result = ids.emplace(std::string(name), static_cast<unsigned int>(names.size()));
+    if (result.second)
+    {
+        names.push_back(result.first->first);
+    }
+    return result.first->second;
+}
+
+bool nameTable::find(std::string_view name, unsigned int& id) const
+{
+    auto it = ids.find(std::string(name));
+    if (it == ids.end())
+    {
+        return false;
+    }
+    id = it->second;
+    return true;
+}
+
+const std::string& nameTable::getName(unsigned int id) const
+{
+    static const std::string unknown;
+    return (id < names.size()) ? names[id] : unknown;
+}
+
+unsigned int nameTable::getCount() const
+{
+    return static_cast<unsigned int>(names.size());
+}
+
+nameTable& getComponentNames()
+{
+    static nameTable names;
+    return names;
+}
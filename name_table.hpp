@@ -0,0 +1,29 @@
+#ifndef NAME_TABLE_HPP
+#define NAME_TABLE_HPP
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Interned names: every distinct name gets a small integer ID (in order of
+// first use), so lookups and compares after loading are integer ones
+class nameTable
+{
+private:
+    std::unordered_map<std::string, unsigned int> ids;
+    std::vector<std::string> names;
+
+public:
+    // ID of a name (added if it is new)
+    unsigned int intern(std::string_view name);
+    // ID of a known name
+    bool find(std::string_view name, unsigned int& id) const;
+    const std::string& getName(unsigned int id) const;
+    unsigned int getCount() const;
+};
+
+// Chess component names (shared by the loader, the target specs and the boards)
+nameTable& getComponentNames();
+
+#endif
@@ -0,0 +1,278 @@
+/*
+Objective:
+Ray picking benchmark (separate executable, not linked into the viewer)
+Description :
+    Checks the picking hierarchies of chessPicking.h against a brute force ray
+    cast and times them: random rays are cast at a field of instance boxes (as
+    built, then after the boxes moved and the tree was refit) and at a triangle
+    mesh, and the closest hit of every ray must match the one found by testing
+    every box or triangle. Exits with 1 on any mismatch.
+
+    Build   : g++ -O2 -std=c++17 pick_bench.cpp chessPicking.cpp -o pick_bench
+    Usage   : pick_bench [ray count] [box count] [triangle count]
+    Default : pick_bench 2000 3300 20000
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "chessPicking.h"
+
+// Minimum time spent on each measurement (best run is reported)
+const double BENCH_MIN_MS = 200.0;
+// Relative hit distance difference still counted as the same hit
+const float PICK_T_TOLERANCE = 1e-5f;
+
+// Synthetic mesh: a bumpy sphere grid (16 bit indices, like the chess meshes)
+typedef struct
+{
+    std::vector<glm::vec3> vertices;
+    std::vector<unsigned short> indices;
+} benchMeshT;
+
+// Closest hit of a ray
+typedef struct
+{
+    bool hit;
+    float t;
+} pickHitT;
+
+// Makes a grid mesh with about triangleCnt triangles
+static benchMeshT makeMesh(unsigned int triangleCnt)
+{
+    benchMeshT mesh;
+    unsigned int side = std::max(2U, std::min(256U, static_cast<unsigned int>(std::sqrt(triangleCnt / 2.0)) + 1));
+    for (unsigned int row = 0; row < side; row++)
+    {
+        for (unsigned int col = 0; col < side; col++)
+        {
+            float u = col / static_cast<float>(side - 1);
+            float v = row / static_cast<float>(side - 1);
+            float theta = 6.2831853f * u;
+            float phi = 3.1415926f * (0.02f + 0.96f * v);
+            float r = 10.f + 0.5f * std::sin(13.f * theta) * std::sin(7.f * phi);
+            glm::vec3 dir(std::sin(phi) * std::cos(theta), std::cos(phi), std::sin(phi) * std::sin(theta));
+            mesh.vertices.push_back(dir * r);
+        }
+    }
+    for (unsigned int row = 0; row + 1 < side; row++)
+    {
+        for (unsigned int col = 0; col + 1 < side; col++)
+        {
+            unsigned short a = static_cast<unsigned short>(row * side + col);
+            unsigned short b = static_cast<unsigned short>(a + 1);
+            unsigned short c = static_cast<unsigned short>(a + side);
+            unsigned short d = static_cast<unsigned short>(c + 1);
+            mesh.indices.insert(mesh.indices.end(), {a, c, b, b, c, d});
+        }
+    }
+    return mesh;
+}
+
+// Instance boxes scattered over a dashboard sized area, a few units tall
+static std::vector<aabbT> makeBoxes(unsigned int boxCnt, std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> pos(-100.f, 100.f);
+    std::uniform_real_distribution<float> size(0.5f, 2.f);
+    std::vector<aabbT> boxes(boxCnt);
+    for (aabbT& box : boxes)
+    {
+        glm::vec3 center(pos(rng), pos(rng), size(rng));
+        glm::vec3 half(size(rng) * 0.5f, size(rng) * 0.5f, size(rng));
+        box = {center - half, center + half};
+    }
+    return boxes;
+}
+
+// Rays from a sphere around the scene aimed inside its bounds (most of them hit)
+static std::vector<pickRayT> makeRays(unsigned int rayCnt, const aabbT& bounds, std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> unit(0.f, 1.f);
+    glm::vec3 center = (bounds.bMin + bounds.bMax) * 0.5f;
+    glm::vec3 extent = bounds.bMax - bounds.bMin;
+    float radius = glm::length(extent) * 1.5f;
+    std::vector<pickRayT> rays(rayCnt);
+    for (pickRayT& ray : rays)
+    {
+        float z = 2.f * unit(rng) - 1.f;
+        float phi = 6.2831853f * unit(rng);
+        float s = std::sqrt(1.f - z * z);
+        glm::vec3 orig = center + radius * glm::vec3(s * std::cos(phi), s * std::sin(phi), z);
+        glm::vec3 target = bounds.bMin + extent * glm::vec3(unit(rng), unit(rng), unit(rng));
+        ray = makePickRay(orig, target - orig);
+    }
+    return rays;
+}
+
+// Closest box entry, every box tested
+static pickHitT bruteBoxes(const std::vector<aabbT>& boxes, const pickRayT& ray)
+{
+    pickHitT best = {false, INFINITY};
+    for (const aabbT& box : boxes)
+    {
+        float tEnter;
+        if (intersectBox(ray, box, best.t, tEnter) && tEnter < best.t)
+        {
+            best = {true, tEnter};
+        }
+    }
+    return best;
+}
+
+// Closest box entry through the hierarchy
+static pickHitT bvhBoxes(const boxBvh& bvh, const std::vector<aabbT>& boxes, const pickRayT& ray)
+{
+    pickHitT best = {false, INFINITY};
+    bvh.traverse(ray, INFINITY, [&](uint32_t bIdx, float tMax)
+    {
+        float tEnter;
+        if (intersectBox(ray, boxes[bIdx], tMax, tEnter) && tEnter < tMax)
+        {
+            best = {true, tEnter};
+            return tEnter;
+        }
+        return tMax;
+    });
+    return best;
+}
+
+// Closest triangle hit, every triangle tested (Moller-Trumbore, both faces)
+static pickHitT bruteMesh(const benchMeshT& mesh, const pickRayT& ray)
+{
+    pickHitT best = {false, INFINITY};
+    for (std::size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+    {
+        const glm::vec3& v0 = mesh.vertices[mesh.indices[i]];
+        glm::vec3 e1 = mesh.vertices[mesh.indices[i + 1]] - v0;
+        glm::vec3 e2 = mesh.vertices[mesh.indices[i + 2]] - v0;
+        glm::vec3 p = glm::cross(ray.dir, e2);
+        float det = glm::dot(e1, p);
+        if (std::fabs(det) < 1e-12f)
+        {
+            continue;
+        }
+        float invDet = 1.f / det;
+        glm::vec3 s = ray.orig - v0;
+        float u = glm::dot(s, p) * invDet;
+        glm::vec3 q = glm::cross(s, e1);
+        float v = glm::dot(ray.dir, q) * invDet;
+        float t = glm::dot(e2, q) * invDet;
+        if (u >= 0.f && v >= 0.f && u + v <= 1.f && t >= 0.f && t < best.t)
+        {
+            best = {true, t};
+        }
+    }
+    return best;
+}
+
+static bool sameHit(const pickHitT& a, const pickHitT& b)
+{
+    return a.hit == b.hit && (!a.hit || std::fabs(a.t - b.t) <= PICK_T_TOLERANCE * std::max(1.f, a.t));
+}
+
+// Best time of a function over BENCH_MIN_MS (milliseconds per call)
+template <typename fnT>
+static double timeBest(fnT fn)
+{
+    typedef std::chrono::steady_clock clockT;
+    double best = 1e30;
+    double total = 0.0;
+    unsigned int runs = 0;
+    while (total < BENCH_MIN_MS || runs < 3)
+    {
+        clockT::time_point start = clockT::now();
+        fn();
+        double ms = std::chrono::duration<double, std::milli>(clockT::now() - start).count();
+        best = std::min(best, ms);
+        total += ms;
+        runs++;
+    }
+    return best;
+}
+
+// Compares the hierarchy against brute force on every ray, times both
+// Inputs: label, rays, closest hit functions (hierarchy, brute force)
+// Output: mismatching rays
+template <typename bvhT, typename bruteT>
+static unsigned int compareRays(const char* label, const std::vector<pickRayT>& rays, bvhT bvhHit, bruteT bruteHit)
+{
+    unsigned int hits = 0, mismatches = 0;
+    for (const pickRayT& ray : rays)
+    {
+        pickHitT expected = bruteHit(ray);
+        hits += expected.hit ? 1 : 0;
+        mismatches += sameHit(bvhHit(ray), expected) ? 0 : 1;
+    }
+
+    volatile float sink = 0.f;
+    double bvhMs = timeBest([&] {
+        for (const pickRayT& ray : rays)
+        {
+            sink = sink + bvhHit(ray).t;
+        }
+    });
+    double bruteMs = timeBest([&] {
+        for (const pickRayT& ray : rays)
+        {
+            sink = sink + bruteHit(ray).t;
+        }
+    });
+    double rayCnt = static_cast<double>(rays.size());
+    std::printf("%-16s %6u/%-6zu %8u %12.3f %12.3f %8.1fx\n", label, hits, rays.size(), mismatches,
+                bvhMs * 1000.0 / rayCnt, bruteMs * 1000.0 / rayCnt, bruteMs / bvhMs);
+    return mismatches;
+}
+
+int main(int argc, char* argv[])
+{
+    unsigned int rayCnt = (argc > 1) ? static_cast<unsigned int>(std::strtoul(argv[1], nullptr, 10)) : 2000;
+    unsigned int boxCnt = (argc > 2) ? static_cast<unsigned int>(std::strtoul(argv[2], nullptr, 10)) : 3300;
+    unsigned int triangleCnt = (argc > 3) ? static_cast<unsigned int>(std::strtoul(argv[3], nullptr, 10)) : 20000;
+    std::mt19937 rng(1);
+
+    // Instance boxes, as built and after they moved (refit keeps the topology)
+    std::vector<aabbT> boxes = makeBoxes(boxCnt, rng);
+    boxBvh bvh;
+    double buildMs = timeBest([&] { bvh.build(boxes); });
+    std::vector<aabbT> moved = boxes;
+    std::uniform_real_distribution<float> step(-3.f, 3.f);
+    for (aabbT& box : moved)
+    {
+        glm::vec3 offset(step(rng), step(rng), 0.f);
+        box = {box.bMin + offset, box.bMax + offset};
+    }
+    boxBvh refit;
+    refit.build(boxes);
+    double refitMs = timeBest([&] { refit.refit(moved); });
+
+    benchMeshT mesh = makeMesh(triangleCnt);
+    meshBvh meshTree;
+    double meshBuildMs = timeBest([&] {
+        meshTree.build(meshSpan<const glm::vec3>(mesh.vertices), meshSpan<const unsigned short>(mesh.indices));
+    });
+
+    std::printf("%u boxes: build %.3f ms, refit %.3f ms\n", boxCnt, buildMs, refitMs);
+    std::printf("%zu triangles: build %.3f ms\n\n", mesh.indices.size() / 3, meshBuildMs);
+    std::printf("%-16s %13s %8s %12s %12s %9s\n", "rays", "hits", "mismatch", "bvh us/ray", "brute us/ray", "speedup");
+
+    unsigned int mismatches = 0;
+    mismatches += compareRays("boxes", makeRays(rayCnt, bvh.getBounds(), rng),
+                              [&](const pickRayT& ray) { return bvhBoxes(bvh, boxes, ray); },
+                              [&](const pickRayT& ray) { return bruteBoxes(boxes, ray); });
+    mismatches += compareRays("boxes refit", makeRays(rayCnt, refit.getBounds(), rng),
+                              [&](const pickRayT& ray) { return bvhBoxes(refit, moved, ray); },
+                              [&](const pickRayT& ray) { return bruteBoxes(moved, ray); });
+    mismatches += compareRays("mesh", makeRays(rayCnt, meshTree.getBounds(), rng),
+                              [&](const pickRayT& ray)
+                              {
+                                  pickHitT hit = {false, INFINITY};
+                                  hit.hit = meshTree.intersect(ray, INFINITY, hit.t);
+                                  return hit.hit ? hit : pickHitT{false, INFINITY};
+                              },
+                              [&](const pickRayT& ray) { return bruteMesh(mesh, ray); });
+    return (mismatches == 0) ? 0 : 1;
+}
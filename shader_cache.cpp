@@ -0,0 +1,260 @@
+#include "shader_cache.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cerrno>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Cache file header
+typedef struct
+{
+    uint32_t magic;
+    uint32_t format;
+    uint32_t length;
+} shaderCacheHeaderT;
+
+static const uint32_t SHADER_CACHE_MAGIC = 0x43485342; // "BSHC"
+
+static bool readTextFile(const char* path, std::string& text)
+{
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file.is_open())
+    {
+        std::cout << "Impossible to open " << path << std::endl;
+        return false;
+    }
+    std::stringstream ss;
+    ss << file.rdbuf();
+    text = ss.str();
+    return true;
+}
+
+// FNV-1a, chained over the cache key parts
+static uint64_t hashText(uint64_t hash, const char* text)
+{
+    for (const char* c = text; c != nullptr && *c != '\0'; c++)
+    {
+        hash ^= static_cast<unsigned char>(*c);
+        hash *= 0x100000001b3ULL;
+    }
+    // Separator so ("ab", "c") and ("a", "bc") differ
+    hash ^= 0xff;
+    hash *= 0x100000001b3ULL;
+    return hash;
+}
+
+// Puts the defines right after the #version line
+static std::string injectDefines(const std::string& source, const char* defines)
+{
+    if (defines == nullptr || *defines == '\0')
+    {
+        return source;
+    }
+    std::size_t pos = 0;
+    if (source.compare(0, 8, "#version") == 0)
+    {
+        pos = source.find('\n');
+        pos = (pos == std::string::npos) ? source.size() : pos + 1;
+    }
+    return source.substr(0, pos) + defines + "\n" + source.substr(pos);
+}
+
+static GLuint compileShader(GLenum type, const std::string& source, const char* path)
+{
+    GLuint shaderID = glCreateShader(type);
+    const char* sourcePointer = source.c_str();
+    GLint result = GL_FALSE;
+    int infoLogLength = 0;
+
+    glShaderSource(shaderID, 1, &sourcePointer, NULL);
+    glCompileShader(shaderID);
+
+    glGetShaderiv(shaderID, GL_COMPILE_STATUS, &result);
+    glGetShaderiv(shaderID, GL_INFO_LOG_LENGTH, &infoLogLength);
+    if (infoLogLength > 0)
+    {
+        std::vector<char> errorMessage(infoLogLength + 1);
+        glGetShaderInfoLog(shaderID, infoLogLength, NULL, &errorMessage[0]);
+        std::cout << path << ": " << &errorMessage[0] << std::endl;
+    }
+    if (result != GL_TRUE)
+    {
+        glDeleteShader(shaderID);
+        return 0;
+    }
+    return shaderID;
+}
+
+static bool isLinked(GLuint programID)
+{
+    GLint result = GL_FALSE;
+    glGetProgramiv(programID, GL_LINK_STATUS, &result);
+    return result == GL_TRUE;
+}
+
+static GLuint loadProgramBinary(const std::string& cachePath)
+{
+    std::ifstream file(cachePath, std::ios::in | std::ios::binary);
+    shaderCacheHeaderT header;
+
+    if (!file.is_open() ||
+        !file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        header.magic != SHADER_CACHE_MAGIC || header.length == 0)
+    {
+        return 0;
+    }
+    std::vector<char> binary(header.length);
+    if (!file.read(&binary[0], header.length))
+    {
+        return 0;
+    }
+
+    GLuint programID = glCreateProgram();
+    glProgramBinary(programID, header.format, &binary[0], header.length);
+    // Drivers reject binaries after updates or for other hardware
+    if (!isLinked(programID))
+    {
+        glDeleteProgram(programID);
+        return 0;
+    }
+    return programID;
+}
+
+static bool writeAll(int fd, const char* data, std::size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t n = write(fd, data, size);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            return false;
+        }
+        data += n;
+        size -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+static void storeProgramBinary(GLuint programID, const std::string& cachePath)
+{
+    GLint length = 0;
+    glGetProgramiv(programID, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+    {
+        return;
+    }
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(programID, length, NULL, &format, &binary[0]);
+    shaderCacheHeaderT header = {SHADER_CACHE_MAGIC, format, static_cast<uint32_t>(length)};
+
+    // Write to a file of our own and rename it, so concurrent viewers never
+    // read a partial file nor write into the same temporary one
+    mkdir(SHADER_CACHE_DIR, 0755);
+    std::string tmpPath = cachePath + ".XXXXXX";
+    int fd = mkstemp(&tmpPath[0]);
+    if (fd < 0)
+    {
+        return;
+    }
+    fchmod(fd, 0644);
+    bool written = writeAll(fd, reinterpret_cast<const char*>(&header), sizeof(header)) &&
+                   writeAll(fd, &binary[0], binary.size());
+    written = (close(fd) == 0) && written;
+    if (!written || std::rename(tmpPath.c_str(), cachePath.c_str()) != 0)
+    {
+        std::remove(tmpPath.c_str());
+    }
+}
+
+GLuint loadCachedShaders(const char* vertexFilePath, const char* fragmentFilePath, const char* defines)
+{
+    std::string vertexShaderCode, fragmentShaderCode;
+    if (!readTextFile(vertexFilePath, vertexShaderCode) ||
+        !readTextFile(fragmentFilePath, fragmentShaderCode))
+    {
+        return 0;
+    }
+    vertexShaderCode = injectDefines(vertexShaderCode, defines);
+    fragmentShaderCode = injectDefines(fragmentShaderCode, defines);
+
+    // Program binaries are only usable if the driver exposes a format
+    GLint formatCnt = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCnt);
+    bool useCache = (formatCnt > 0);
+
+    // Key on everything that invalidates a binary
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    hash = hashText(hash, vertexShaderCode.c_str());
+    hash = hashText(hash, fragmentShaderCode.c_str());
+    hash = hashText(hash, reinterpret_cast<const char*>(glGetString(GL_VENDOR)));
+    hash = hashText(hash, reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+    hash = hashText(hash, reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+    char hashName[17];
+    std::snprintf(hashName, sizeof(hashName), "%016llx", static_cast<unsigned long long>(hash));
+    std::string cachePath = std::string(SHADER_CACHE_DIR) + "/" + hashName + ".bin";
+
+    if (useCache)
+    {
+        GLuint programID = loadProgramBinary(cachePath);
+        if (programID != 0)
+        {
+            return programID;
+        }
+    }
+
+    // Cache miss (or rejected binary): build from source
+    GLuint vertexShaderID = compileShader(GL_VERTEX_SHADER, vertexShaderCode, vertexFilePath);
+    GLuint fragmentShaderID = compileShader(GL_FRAGMENT_SHADER, fragmentShaderCode, fragmentFilePath);
+    if (vertexShaderID == 0 || fragmentShaderID == 0)
+    {
+        glDeleteShader(vertexShaderID);
+        glDeleteShader(fragmentShaderID);
+        return 0;
+    }
+
+    GLuint programID = glCreateProgram();
+    glAttachShader(programID, vertexShaderID);
+    glAttachShader(programID, fragmentShaderID);
+    if (useCache)
+    {
+        glProgramParameteri(programID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    glLinkProgram(programID);
+
+    GLint infoLogLength = 0;
+    glGetProgramiv(programID, GL_INFO_LOG_LENGTH, &infoLogLength);
+    if (infoLogLength > 0)
+    {
+        std::vector<char> errorMessage(infoLogLength + 1);
+        glGetProgramInfoLog(programID, infoLogLength, NULL, &errorMessage[0]);
+        std::cout << &errorMessage[0] << std::endl;
+    }
+
+    glDetachShader(programID, vertexShaderID);
+    glDetachShader(programID, fragmentShaderID);
+    glDeleteShader(vertexShaderID);
+    glDeleteShader(fragmentShaderID);
+
+    if (!isLinked(programID))
+    {
+        glDeleteProgram(programID);
+        return 0;
+    }
+    if (useCache)
+    {
+        storeProgramBinary(programID, cachePath);
+    }
+    return programID;
+}
@@ -0,0 +1,15 @@
+#ifndef SHADER_CACHE_HPP
+#define SHADER_CACHE_HPP
+
+#include <GL/glew.h>
+
+// Directory holding the cached program binaries
+#define SHADER_CACHE_DIR ".shadercache"
+
+// Builds a GLSL program, reusing the driver's program binary from the
+// on-disk cache when the sources, defines and driver all match.
+// defines is injected right after the #version line (may be empty).
+// Returns 0 if the program fails to compile or link.
+GLuint loadCachedShaders(const char* vertexFilePath, const char* fragmentFilePath, const char* defines);
+
+#endif
@@ -0,0 +1,202 @@
+#include "uci_engine.hpp"
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+uciEngine::uciEngine()
+{
+    pid = -1;
+    toEngine = -1;
+    fromEngine = -1;
+}
+
+uciEngine::~uciEngine()
+{
+    stop();
+}
+
+bool uciEngine::start(const std::string& path)
+{
+    stop();
+    enginePath = path;
+    int inPipe[2], outPipe[2];
+    if (pipe2(inPipe, O_CLOEXEC) != 0)
+    {
+        return false;
+    }
+    if (pipe2(outPipe, O_CLOEXEC) != 0)
+    {
+        close(inPipe[0]);
+        close(inPipe[1]);
+        return false;
+    }
+    // A dead engine must fail the write, not kill the viewer
+    signal(SIGPIPE, SIG_IGN);
+
+    pid = fork();
+    if (pid == 0)
+    { // Engine side: stdin and stdout on the pipes (dup2 clears close-on-exec)
+        dup2(inPipe[0], STDIN_FILENO);
+        dup2(outPipe[1], STDOUT_FILENO);
+        execl(enginePath.c_str(), enginePath.c_str(), static_cast<char*>(nullptr));
+        _exit(127);
+    }
+    close(inPipe[0]);
+    close(outPipe[1]);
+    toEngine = inPipe[1];
+    fromEngine = outPipe[0];
+    if (pid < 0)
+    {
+        stop();
+        return false;
+    }
+    inBuf.clear();
+    if (!writeAll("uci\n") || !waitFor("uciok") || !writeAll("isready\n") || !waitFor("readyok"))
+    {
+        std::cout << "Cannot start the chess engine " << enginePath << std::endl;
+        stop();
+        return false;
+    }
+    return true;
+}
+
+void uciEngine::stop()
+{
+    if (toEngine >= 0)
+    {
+        writeAll("quit\n");
+        close(toEngine);
+        toEngine = -1;
+    }
+    if (fromEngine >= 0)
+    {
+        close(fromEngine);
+        fromEngine = -1;
+    }
+    if (pid > 0)
+    {
+        // Closed pipes end a well behaved engine, anything else is killed
+        int status;
+        for (int tries = 0; tries < 50 && waitpid(pid, &status, WNOHANG) == 0; tries++)
+        {
+            usleep(10000);
+        }
+        if (waitpid(pid, &status, WNOHANG) == 0)
+        {
+            kill(pid, SIGKILL);
+            waitpid(pid, &status, 0);
+        }
+    }
+    pid = -1;
+}
+
+bool uciEngine::isRunning() const
+{
+    return pid > 0;
+}
+
+bool uciEngine::writeAll(std::string_view text)
+{
+    while (!text.empty())
+    {
+        ssize_t n = write(toEngine, text.data(), text.size());
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            return false;
+        }
+        text.remove_prefix(static_cast<std::size_t>(n));
+    }
+    return true;
+}
+
+bool uciEngine::readLine(int timeoutMs)
+{
+    char chunk[4096];
+    while (true)
+    {
+        std::size_t end = inBuf.find('\n');
+        if (end != std::string::npos)
+        {
+            std::size_t len = (end > 0 && inBuf[end - 1] == '\r') ? end - 1 : end;
+            line.assign(inBuf, 0, len);
+            inBuf.erase(0, end + 1);
+            return true;
+        }
+        pollfd pfd = {fromEngine, POLLIN, 0};
+        int ready = poll(&pfd, 1, timeoutMs);
+        if (ready < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (ready <= 0)
+        {
+            return false;
+        }
+        ssize_t n = read(fromEngine, chunk, sizeof(chunk));
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            return false;
+        }
+        inBuf.append(chunk, static_cast<std::size_t>(n));
+    }
+}
+
+bool uciEngine::waitFor(std::string_view token)
+{
+    while (readLine(UCI_READ_TIMEOUT_MS))
+    {
+        if (std::string_view(line).compare(0, token.size(), token) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool uciEngine::requestMove(std::string_view moves, std::string& bestMove, engineStats& stats)
+{
+    if (pid <= 0 && (enginePath.empty() || !start(enginePath)))
+    {
+        return false;
+    }
+    request = "position startpos moves ";
+    request.append(moves);
+    request += "\ngo movetime ";
+    request += std::to_string(UCI_MOVE_TIME_MS);
+    request += '\n';
+    if (!writeAll(request))
+    {
+        stop();
+        return false;
+    }
+
+    // "bestmove e7e5 ponder g1f3", the info lines before it feed the stats
+    while (readLine(UCI_READ_TIMEOUT_MS))
+    {
+        std::string_view text(line);
+        if (text.compare(0, 9, "bestmove ") != 0)
+        {
+            stats.recordInfoLine(text);
+            continue;
+        }
+        text.remove_prefix(9);
+        bestMove.assign(text.substr(0, text.find(' ')));
+        return true;
+    }
+    // Silent or gone: a later request starts over with a fresh engine
+    stop();
+    return false;
+}
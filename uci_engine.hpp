@@ -0,0 +1,52 @@
+#ifndef UCI_ENGINE_HPP
+#define UCI_ENGINE_HPP
+
+#include <string>
+#include <string_view>
+#include <sys/types.h>
+#include "engine_stats.hpp"
+
+// Engine binary (relative to the working directory) and search budget
+#define UCI_ENGINE_PATH "./komodo"
+const unsigned int UCI_MOVE_TIME_MS = 1000;
+// Longest silence from the engine before an exchange is given up (milliseconds)
+const int UCI_READ_TIMEOUT_MS = 30000;
+
+// UCI engine on a pair of pipes. The position is sent whole with every
+// request (the engine keeps nothing between them), and every line read while
+// it searches goes to the engine stats.
+class uciEngine
+{
+private:
+    std::string enginePath;    // Kept to restart an engine that died or hung
+    pid_t pid;
+    int toEngine;
+    int fromEngine;
+    std::string inBuf;         // Read, not yet split into lines
+    std::string line;
+    std::string request;
+
+    bool writeAll(std::string_view text);
+    // Next line (without its newline), false on timeout, end of file or error
+    bool readLine(int timeoutMs);
+    // Reads lines up to one starting with the token
+    bool waitFor(std::string_view token);
+
+public:
+    uciEngine();
+    ~uciEngine();
+    uciEngine(const uciEngine&) = delete;
+    uciEngine& operator=(const uciEngine&) = delete;
+
+    // Starts the engine and waits until it is ready
+    bool start(const std::string& path);
+    // Asks the engine to quit and reaps it
+    void stop();
+    bool isRunning() const;
+    // Best move for the position reached by the moves (long algebraic
+    // notation, space separated) from the start position. Lines read while
+    // the engine searches are handed to stats.recordInfoLine.
+    bool requestMove(std::string_view moves, std::string& bestMove, engineStats& stats);
+};
+
+#endif